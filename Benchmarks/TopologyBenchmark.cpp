@@ -0,0 +1,114 @@
+// Compares the memory use and query latency of the CSR GraphTopology against the
+// std::vector<std::set<size_t>> adjacency it replaced.
+// Build with "make topology_benchmark"; prints one CSV row per configuration.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+#include "../World/GraphColorWorld/GraphTopology.h"
+
+// Tallies every byte the set-based adjacency allocates
+static size_t set_bytes = 0;
+
+template<class T>
+struct CountingAllocator{
+    using value_type = T;
+    CountingAllocator() = default;
+    template<class U> CountingAllocator(const CountingAllocator<U>&){}
+    T* allocate(size_t n){
+        set_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n){
+        set_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+    template<class U> bool operator==(const CountingAllocator<U>&) const{ return true; }
+    template<class U> bool operator!=(const CountingAllocator<U>&) const{ return false; }
+};
+
+using SetRow = std::set<size_t, std::less<size_t>, CountingAllocator<size_t>>;
+
+static double seconds_since(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(size_t num_nodes, double avg_degree, GraphTopology::BitsetPolicy policy, uint32_t seed){
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint32_t> pick(0, num_nodes - 1);
+    size_t num_edges = (size_t)(num_nodes * avg_degree / 2);
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    edges.reserve(num_edges);
+    while(edges.size() < num_edges){
+        uint32_t a = pick(rng), b = pick(rng);
+        if(a != b)
+            edges.push_back({a, b});
+    }
+    // Half the queries hit an edge, half are random pairs
+    std::vector<std::pair<uint32_t, uint32_t>> queries(1000000);
+    for(size_t i = 0; i < queries.size(); ++i)
+        queries[i] = (i & 1) ? edges[rng() % edges.size()] : std::make_pair(pick(rng), pick(rng));
+
+    // Old layout
+    set_bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SetRow> adj_vec(num_nodes);
+    for(auto& e : edges){
+        adj_vec[e.first].insert(e.second);
+        adj_vec[e.second].insert(e.first);
+    }
+    double set_build = seconds_since(start);
+    size_t set_memory = set_bytes + adj_vec.capacity() * sizeof(SetRow);
+    size_t hits = 0;
+    start = std::chrono::steady_clock::now();
+    for(auto& q : queries)
+        hits += adj_vec[q.first].find(q.second) != adj_vec[q.first].end();
+    double set_query = seconds_since(start);
+    size_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    for(size_t n = 0; n < num_nodes; ++n)
+        for(size_t m : adj_vec[n])
+            sum += m;
+    double set_scan = seconds_since(start);
+
+    // CSR layout
+    auto edges_copy = edges;
+    start = std::chrono::steady_clock::now();
+    GraphTopology topo(num_nodes);
+    topo.build(edges_copy, policy);
+    double csr_build = seconds_since(start);
+    size_t csr_hits = 0;
+    start = std::chrono::steady_clock::now();
+    for(auto& q : queries)
+        csr_hits += topo.check_neighbors(q.first, q.second);
+    double csr_query = seconds_since(start);
+    size_t csr_sum = 0;
+    start = std::chrono::steady_clock::now();
+    for(size_t n = 0; n < num_nodes; ++n)
+        for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m)
+            csr_sum += *m;
+    double csr_scan = seconds_since(start);
+
+    if(hits != csr_hits || sum != csr_sum)
+        std::fprintf(stderr, "Mismatch between layouts at %zu nodes!\n", num_nodes);
+    std::printf("%zu,%zu,%d,%zu,%zu,%.6f,%.6f,%.2f,%.2f,%.3f,%.3f\n",
+        num_nodes, topo.edge_count, !topo.adj_bits.empty(),
+        set_memory, topo.memory_usage(), set_build, csr_build,
+        set_query * 1e9 / queries.size(), csr_query * 1e9 / queries.size(),
+        set_scan * 1e9 / (2 * topo.edge_count), csr_scan * 1e9 / (2 * topo.edge_count));
+}
+
+int main(){
+    std::printf("nodes,edges,bitset,set_bytes,csr_bytes,set_build_s,csr_build_s,"
+                "set_query_ns,csr_query_ns,set_scan_ns_per_edge,csr_scan_ns_per_edge\n");
+    for(size_t num_nodes : {10000, 100000}){
+        run(num_nodes, 10, GraphTopology::BITSET_AUTO, 1);
+        run(num_nodes, 100, GraphTopology::BITSET_AUTO, 2);
+    }
+    // Dense enough for the bit matrix to pay for itself
+    run(10000, 1000, GraphTopology::BITSET_AUTO, 3);
+    run(10000, 1000, GraphTopology::BITSET_NEVER, 3);
+    return 0;
+}
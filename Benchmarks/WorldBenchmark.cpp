@@ -0,0 +1,508 @@
+// Measures the throughput of GraphColorWorld's evaluation loop on its own, without the
+// optimizer, archivist or file output of a full MABE run. Every configuration runs
+// runEvaluation (the body of evaluateSolo) on graphs and evaluation seeds that are
+// fixed by --seed, so runs are directly comparable across builds.
+// Build with "make world_benchmark" (needs the MABE submodule); prints one CSV row per
+// configuration.
+//
+// Usage: world_benchmark [--nodes 100,1000] [--density 0.01,0.05] [--lifetime 100,1000]
+//                        [--brains hash,chatty] [--graph file] [--evals 5] [--seed 1]
+//                        [--random mt19937|philox]
+//        world_benchmark --check 4 [--seed 1]
+//
+// --check compares evaluations instead of timing them, and exits 1 if any differ in score,
+// graph score, sends, reads, color changes or rounds: the lifetime loop specialised for
+// each combination of I/O bits against a plain reference loop, nodeThreads against serial
+// node updates, and evaluationThreads and evaluationProcesses against serial evaluation.
+// Threaded paths run with the given number of threads or processes (at least 2).
+//
+// Brains are synthetic so that the numbers measure the world rather than one brain type:
+//   hash          outputs are a hash of the inputs and internal state (a busy, evolved-looking brain)
+//   chatty        hash outputs, but every action bit is on and every veto bit off: send, read
+//                 and recolor every tick
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <queue>
+#include <random>
+#include <sstream>
+#include "World/GraphColorWorld/GraphColorWorld.h"
+
+// Counts every heap allocation in the process, to report allocations per tick
+static std::atomic<size_t> allocation_count(0);
+
+void* operator new(size_t size){
+    ++allocation_count;
+    if(void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept{
+    std::free(p);
+}
+
+class BenchmarkBrain : public AbstractBrain{
+public:
+    uint64_t genome;
+    uint64_t state = 0;
+    std::vector<int8_t> forcedOutputs;  // Per output: -1 to use the hash, otherwise the fixed value
+
+    BenchmarkBrain(int ins, int outs, uint64_t genome_, std::vector<int8_t> forcedOutputs_ = {})
+        : AbstractBrain(ins, outs, nullptr), genome(genome_), forcedOutputs(forcedOutputs_){
+        forcedOutputs.resize(outs, -1);
+    }
+
+    virtual void update() override{
+        uint64_t h = genome ^ state;
+        for(int i = 0; i < nrInputValues; ++i)
+            h = (h ^ (uint64_t)(inputValues[i] > 0)) * 0x100000001b3ULL + 7;
+        state = h >> 7;
+        for(int o = 0; o < nrOutputValues; ++o){
+            h ^= h >> 13;
+            h *= 0x9E3779B97F4A7C15ULL;
+            outputValues[o] = forcedOutputs[o] >= 0 ? forcedOutputs[o] : (double)((h >> 60) & 1);
+        }
+    }
+
+    virtual void resetBrain() override{
+        AbstractBrain::resetBrain();
+        state = 0;
+    }
+
+    virtual std::shared_ptr<AbstractBrain> makeBrain(
+            std::unordered_map<std::string, std::shared_ptr<AbstractGenome>>& _genomes) override{
+        return makeCopy();
+    }
+
+    virtual std::shared_ptr<AbstractBrain> makeCopy(std::shared_ptr<ParametersTable> PT_ = nullptr) override{
+        return std::make_shared<BenchmarkBrain>(*this);
+    }
+
+    virtual std::string description() override{
+        return "Benchmark brain";
+    }
+
+    virtual DataMap getStats(std::string& prefix) override{
+        return DataMap();
+    }
+
+    virtual std::string getType() override{
+        return "Benchmark";
+    }
+};
+
+template<class T>
+static std::vector<T> parse_list(const std::string& arg){
+    std::vector<T> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while(std::getline(ss, item, ',')){
+        std::stringstream conv(item);
+        T value;
+        conv >> value;
+        values.push_back(value);
+    }
+    return values;
+}
+
+// The world reports its configuration and statistics on std::cout; keep stdout for the CSV
+struct QuietCout{
+    std::streambuf* saved;
+    std::ostringstream sink;
+    QuietCout() : saved(std::cout.rdbuf(sink.rdbuf())){
+    }
+    ~QuietCout(){
+        std::cout.rdbuf(saved);
+    }
+};
+
+struct Config{
+    std::vector<int> nodes = {100, 1000};
+    std::vector<double> densities = {0.01, 0.05};
+    std::vector<int> lifetimes = {100, 1000};
+    std::vector<std::string> brains = {"hash", "chatty"};
+    std::string graphFile;
+    int evals = 5;
+    uint32_t seed = 1;
+    std::string random = "mt19937";
+    int checkThreads = 0;       // If > 0, run --check instead of the benchmark
+};
+
+static std::shared_ptr<AbstractBrain> make_brain(GraphColorWorld& world, const std::string& brainType, uint64_t genome){
+    if(brainType == "hash")
+        return std::make_shared<BenchmarkBrain>(world.brainInputSize(), world.brainOutputSize(), genome);
+    if(brainType == "chatty"){
+        std::vector<int8_t> forced(world.brainOutputSize(), -1);
+        if(world.useSendMsgBit)
+            forced[world.sendMsgBitPos] = 1;
+        if(world.useSendMsgVetoBit)
+            forced[world.sendMsgVetoBitPos] = 0;
+        if(world.useGetMsgBit)
+            forced[world.getMsgBitPos] = 1;
+        if(world.useGetMsgVetoBit)
+            forced[world.getMsgVetoBitPos] = 0;
+        if(world.useSetColorBit)
+            forced[world.setColorBitPos] = 1;
+        if(world.useSetColorVetoBit)
+            forced[world.setColorVetoBitPos] = 0;
+        return std::make_shared<BenchmarkBrain>(world.brainInputSize(), world.brainOutputSize(), genome, forced);
+    }
+    std::fprintf(stderr, "Unknown brain type \"%s\" (expected hash or chatty)\n", brainType.c_str());
+    exit(-1);
+}
+
+static void run(GraphColorWorld& world, const Config& config, const std::string& brainType, double density){
+    uint64_t genome = 0x9E3779B97F4A7C15ULL * config.seed;
+    std::shared_ptr<AbstractBrain> brain = make_brain(world, brainType, genome);
+
+    GraphColorWorld::EvalContext& ctx = world.contexts[0];
+    GraphColorWorld::EvalResult result;
+    // Untimed warm-up, so pools and inboxes have reached their steady-state size
+    world.runEvaluation(brain, config.seed, 0, 0, ctx, result, 0);
+
+    size_t ticks = 0, messages = 0;
+    size_t allocations = allocation_count;
+    auto start = std::chrono::steady_clock::now();
+    for(int e = 0; e < config.evals; ++e){
+        world.runEvaluation(brain, config.seed + 1 + e, 0, e + 1, ctx, result, 0);
+        // rounds is the tick the evaluation stopped on, or agentLifetime if it ran out
+        ticks += result.rounds < world.agentLifetime ? result.rounds + 1 : world.agentLifetime;
+        messages += ctx.msgQueues.stats.pushed;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    allocations = allocation_count - allocations;
+
+    std::printf("%s,%zu,%.4f,%zu,%d,%d,%zu,%.6f,%.1f,%.1f,%.1f,%.4f,%s\n",
+        brainType.c_str(), world.G.node_count, density, world.G.edge_count, world.agentLifetime,
+        config.evals, ticks, seconds, ticks / seconds, ticks * world.G.node_count / seconds,
+        messages / seconds, (double)allocations / std::max((size_t)1, ticks),
+        config.graphFile.empty() ? "gnp" : config.graphFile.c_str());
+    std::fflush(stdout);
+}
+
+// The lifetime loop written plainly, as evaluateSolo was before it was specialised: every I/O
+// bit is a runtime flag read from the world, every delivery sets all of its inputs, and the
+// inboxes are std::queues. mt19937 randomness only; racing and normalizeGraphScore off.
+static GraphColorWorld::EvalResult reference_evaluation(GraphColorWorld& world, std::shared_ptr<AbstractBrain> brain,
+                                                        uint32_t seed){
+    std::mt19937 rng(seed);
+    auto randInt = [&rng](int i){ return std::uniform_int_distribution<int>(0, i-1)(rng); };
+    Graph G;
+    G.set_topology(world.G.topology);
+    size_t numNodes = G.node_count;
+    std::vector<std::shared_ptr<AbstractBrain>> clones(numNodes);
+    std::vector<size_t> order(numNodes);
+    std::vector<std::queue<std::pair<uint32_t, uint32_t>>> inboxes(numNodes); // (sender, color bits)
+    std::vector<uint8_t> deliver(numNodes, 0);
+    for(size_t i = 0; i < numNodes; ++i){
+        clones[i] = brain->makeCopy(brain->PT);
+        clones[i]->resetBrain();
+        order[i] = i;
+    }
+    G.reset_colors(world.colorSize, rng);
+
+    GraphColorWorld::EvalResult result = GraphColorWorld::EvalResult();
+    double score = 0;
+    size_t t, solveCount = 0;
+    for(t = 0; t < (size_t)world.agentLifetime; ++t){
+        for(size_t id : order){
+            if(deliver[id]){
+                std::pair<uint32_t, uint32_t> msg(0, 0);    // An empty inbox delivers zeros
+                if(!inboxes[id].empty()){
+                    msg = inboxes[id].front();
+                    inboxes[id].pop();
+                }
+                for(size_t i = 0; i < world.addressSize; ++i)
+                    clones[id]->setInput(i, msg.first & 1);
+                for(size_t i = 0; i < world.colorSize; ++i)
+                    clones[id]->setInput(world.addressSize + i, (msg.second >> (world.colorSize - 1 - i)) & 1);
+            }
+            if(world.useNewMsgBit)
+                clones[id]->setInput(world.newMsgBitPos, !inboxes[id].empty());
+        }
+        for(auto& clone : clones)
+            clone->update();
+        std::random_shuffle(order.begin(), order.end(), randInt);
+        for(size_t id : order){
+            auto on = [&](size_t o){ return Bit(clones[id]->readOutput(o)) == 1; };
+            if((!world.useSetColorBit || on(world.setColorBitPos)) && (!world.useSetColorVetoBit || !on(world.setColorVetoBitPos))){
+                uint32_t color = 0;
+                for(size_t i = 0; i < world.colorSize; ++i)
+                    color = (color << 1) | on(world.addressSize + i);
+                G.set_color_bits(id, color);
+                score += 1/((t+1)*(t+1));
+                result.colorChanges++;
+            }
+            if((!world.useSendMsgBit || on(world.sendMsgBitPos)) && (!world.useSendMsgVetoBit || !on(world.sendMsgVetoBitPos))){
+                size_t target = 0;
+                for(size_t i = 0; i < world.addressSize; ++i)
+                    target |= (size_t)on(i) << i;
+                if(target < numNodes && G.check_neighbors(id, target))
+                    inboxes[target].push(std::make_pair((uint32_t)id, G.color_bits[id]));
+                score += 1/((t+1)*(t+1));
+                result.sends++;
+            }
+            deliver[id] = (!world.useGetMsgBit || on(world.getMsgBitPos)) && (!world.useGetMsgVetoBit || !on(world.getMsgVetoBitPos));
+            if(deliver[id]){
+                score += 1/((t+1)*(t+1));
+                result.reads++;
+            }
+        }
+        if(G.check_graph_coloring()){
+            if(++solveCount == 20){
+                score += world.agentLifetime - t;
+                break;
+            }
+        }
+        else{
+            solveCount = 0;
+        }
+    }
+    result.graphScore = G.get_graph_score();
+    result.score = score + result.graphScore;
+    result.rounds = int(t);
+    return result;
+}
+
+static size_t check_mismatches = 0;
+
+static void compare_results(const GraphColorWorld::EvalResult& a, const GraphColorWorld::EvalResult& b,
+                            const std::string& where){
+    if(a.score == b.score && a.graphScore == b.graphScore && a.sends == b.sends && a.reads == b.reads
+            && a.colorChanges == b.colorChanges && a.rounds == b.rounds && a.truncated == b.truncated)
+        return;
+    if(check_mismatches++ < 20)
+        std::printf("MISMATCH %s: score %.10g vs %.10g, graphScore %.10g vs %.10g, sends %d vs %d, reads %d vs %d, "
+                    "color changes %d vs %d, rounds %d vs %d, truncated %d vs %d\n", where.c_str(), a.score, b.score,
+                    a.graphScore, b.graphScore, a.sends, b.sends, a.reads, b.reads, a.colorChanges, b.colorChanges,
+                    a.rounds, b.rounds, (int)a.truncated, (int)b.truncated);
+}
+
+static std::unique_ptr<GraphColorWorld> make_check_world(size_t numNodes, double density, int lifetime, uint32_t seed){
+    std::unique_ptr<GraphColorWorld> world;
+    GraphColorWorld::minGraphNodesPL->set(numNodes);
+    GraphColorWorld::maxGraphNodesPL->set(numNodes);
+    {
+        QuietCout quiet;
+        world.reset(new GraphColorWorld(nullptr));
+    }
+    world->G.randomize(numNodes, density, GraphGenerators::GNP, 2.5, seed);
+    world->agentLifetime = lifetime;
+    return world;
+}
+
+// The specialised loop against the reference, for every combination of the I/O bits
+static void check_specialisation(const Config& config){
+    const char* bits[] = {"useNewMessageBit", "useSendMessageBit", "useSendMessageVetoBit", "useGetMessageBit",
+                          "useGetMessageVetoBit", "useSetColorBit", "useSetColorVetoBit"};
+    std::vector<std::shared_ptr<ParameterLink<int>>> links = {
+        GraphColorWorld::useNewMessageBitPL, GraphColorWorld::useSendMessageBitPL, GraphColorWorld::useSendMessageVetoBitPL,
+        GraphColorWorld::useGetMessageBitPL, GraphColorWorld::useGetMessageVetoBitPL, GraphColorWorld::useSetColorBitPL,
+        GraphColorWorld::useSetColorVetoBitPL};
+    GraphColorWorld::evaluationRandomPL->set("mt19937");
+    size_t evaluations = 0;
+    for(int mask = 0; mask < 1 << links.size(); ++mask){
+        std::string where = "bits";
+        for(size_t b = 0; b < links.size(); ++b){
+            links[b]->set((mask >> b) & 1);
+            if((mask >> b) & 1)
+                where += std::string(" ") + bits[b];
+        }
+        auto world = make_check_world(60, 0.1, 100, config.seed);
+        for(std::string brainType : {"hash", "chatty"}){
+            for(uint32_t e = 0; e < 3; ++e){
+                auto brain = make_brain(*world, brainType, 0x9E3779B97F4A7C15ULL * (config.seed + e));
+                GraphColorWorld::EvalResult result;
+                world->runEvaluation(brain, config.seed + e, 0, e, world->contexts[0], result, 0);
+                compare_results(result, reference_evaluation(*world, brain, config.seed + e), 
+                                where + ", " + brainType + " brain " + std::to_string(e));
+                ++evaluations;
+            }
+        }
+        QuietCout quiet;
+        world.reset();
+    }
+    for(auto& link : links)
+        link->set(1);
+    std::printf("specialised lifetime loop vs reference: %zu evaluations over %d I/O bit combinations\n",
+                evaluations, 1 << (int)links.size());
+}
+
+// nodeThreads against serial node updates, on a graph big enough to be split into blocks
+static void check_node_threads(const Config& config, const std::string& random){
+    int threads = std::max(2, config.checkThreads);
+    GraphColorWorld::evaluationRandomPL->set(random);
+    GraphColorWorld::nodeThreadsPL->set(1);
+    auto serial = make_check_world(3000, 0.002, 50, config.seed);
+    GraphColorWorld::nodeThreadsPL->set(threads);
+    auto threaded = make_check_world(3000, 0.002, 50, config.seed);
+    GraphColorWorld::nodeThreadsPL->set(1);
+    threaded->counterRandomKey = serial->counterRandomKey;
+    size_t evaluations = 0;
+    for(std::string brainType : {"hash", "chatty"}){
+        for(uint32_t e = 0; e < 3; ++e){
+            auto brain = make_brain(*serial, brainType, 0x9E3779B97F4A7C15ULL * (config.seed + e));
+            GraphColorWorld::EvalResult a, b;
+            serial->runEvaluation(brain, config.seed + e, 0, e, serial->contexts[0], a, 0);
+            threaded->runEvaluation(brain, config.seed + e, 0, e, threaded->contexts[0], b, 0);
+            compare_results(a, b, "nodeThreads " + std::to_string(threads) + ", " + random + ", " + brainType 
+                            + " brain " + std::to_string(e));
+            ++evaluations;
+        }
+    }
+    std::printf("nodeThreads %d vs 1 (%s): %zu evaluations on %zu nodes\n", threads, random.c_str(), evaluations,
+                serial->G.node_count);
+    QuietCout quiet;
+    serial.reset();
+    threaded.reset();
+}
+
+// evaluationThreads and evaluationProcesses against serial evaluation of a population of
+// brains, with seeds drawn from MABE's generator as evaluate() draws them
+static void check_evaluation_threads(const Config& config, const std::string& random, int racingEliteCount){
+    int workers = std::max(2, config.checkThreads);
+    GraphColorWorld::evaluationRandomPL->set(random);
+    GraphColorWorld::evaluationsPerGenerationPL->set(2);
+    GraphColorWorld::racingEliteCountPL->set(racingEliteCount);
+    auto serial = make_check_world(200, 0.05, 200, config.seed);
+    GraphColorWorld::evaluationThreadsPL->set(workers);
+    auto threaded = make_check_world(200, 0.05, 200, config.seed);
+    GraphColorWorld::evaluationThreadsPL->set(1);
+    GraphColorWorld::evaluationProcessesPL->set(workers);
+    auto forked = make_check_world(200, 0.05, 200, config.seed);
+    GraphColorWorld::evaluationProcessesPL->set(1);
+    GraphColorWorld::evaluationsPerGenerationPL->set(1);
+    GraphColorWorld::racingEliteCountPL->set(0);
+    threaded->counterRandomKey = forked->counterRandomKey = serial->counterRandomKey;
+
+    std::vector<std::shared_ptr<AbstractBrain>> brains;
+    for(size_t i = 0; i < 16; ++i)
+        brains.push_back(make_brain(*serial, i % 4 == 3 ? "chatty" : "hash", 0x9E3779B97F4A7C15ULL * (config.seed + i)));
+
+    // What evaluate() does serially: evaluateSolo for each organism in turn, setting the
+    // racing threshold once the elite are done
+    Random::getCommonGenerator().seed(config.seed);
+    std::vector<GraphColorWorld::EvalResult> expected;
+    for(size_t i = 0; i < brains.size(); ++i){
+        for(int e = 0; e < serial->evaluationsPerGeneration; ++e){
+            GraphColorWorld::EvalResult result;
+            serial->runEvaluation(brains[i], serial->nextEvaluationSeed(), i, e, serial->contexts[0], result, 0);
+            expected.push_back(result);
+            if(i < serial->racingEliteCount)
+                serial->racingScores.push_back(result.score);
+        }
+        if(i + 1 == serial->racingEliteCount)
+            serial->setRacingThreshold();
+    }
+
+    std::string where = random + (racingEliteCount > 0 ? ", racing" : "");
+    for(GraphColorWorld* world : {threaded.get(), forked.get()}){
+        std::string path = world == threaded.get() ? "evaluationThreads " : "evaluationProcesses ";
+        Random::getCommonGenerator().seed(config.seed);
+        std::vector<GraphColorWorld::EvalResult> results;
+        world->evaluateBrains(brains, results);
+        for(size_t task = 0; task < expected.size(); ++task)
+            compare_results(expected[task], results[task], path + std::to_string(workers) + ", " + where + ", organism "
+                            + std::to_string(task / 2) + " eval " + std::to_string(task % 2));
+    }
+    std::printf("evaluationThreads and evaluationProcesses %d vs serial (%s): %zu evaluations each\n", workers,
+                where.c_str(), expected.size());
+    QuietCout quiet;
+    serial.reset();
+    threaded.reset();
+    forked.reset();
+}
+
+static int check(const Config& config){
+    GraphColorWorld::evaluationThreadsPL->set(1);
+    check_specialisation(config);
+    for(std::string random : {"mt19937", "philox"})
+        check_node_threads(config, random);
+    for(std::string random : {"mt19937", "philox"}){
+        check_evaluation_threads(config, random, 0);
+        check_evaluation_threads(config, random, 4);
+    }
+    std::printf(check_mismatches == 0 ? "All checks passed\n" : "%zu mismatches\n", check_mismatches);
+    return check_mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+    Config config;
+    for(int i = 1; i + 1 < argc; i += 2){
+        std::string flag = argv[i], value = argv[i + 1];
+        if(flag == "--nodes")
+            config.nodes = parse_list<int>(value);
+        else if(flag == "--density")
+            config.densities = parse_list<double>(value);
+        else if(flag == "--lifetime")
+            config.lifetimes = parse_list<int>(value);
+        else if(flag == "--brains")
+            config.brains = parse_list<std::string>(value);
+        else if(flag == "--graph")
+            config.graphFile = value;
+        else if(flag == "--evals")
+            config.evals = std::atoi(value.c_str());
+        else if(flag == "--seed")
+            config.seed = (uint32_t)std::atoi(value.c_str());
+        else if(flag == "--random")
+            config.random = value;
+        else if(flag == "--check")
+            config.checkThreads = std::atoi(value.c_str());
+        else{
+            std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+            return 1;
+        }
+    }
+    if(argc % 2 == 0){
+        std::fprintf(stderr, "Option %s is missing a value\n", argv[argc - 1]);
+        return 1;
+    }
+    GraphColorWorld::graphLogFormatPL->set("none");
+    if(config.checkThreads > 0)
+        return check(config);
+    GraphColorWorld::evaluationThreadsPL->set(1);
+    GraphColorWorld::graphFilePL->set(config.graphFile);
+    GraphColorWorld::evaluationRandomPL->set(config.random);
+    // A loaded graph fixes the node count and density
+    if(!config.graphFile.empty()){
+        config.nodes = {0};
+        config.densities = {0};
+    }
+
+    std::printf("brain,nodes,density,edges,lifetime,evals,ticks,seconds,ticks_per_sec,"
+                "node_updates_per_sec,messages_per_sec,allocs_per_tick,graph\n");
+    for(int numNodes : config.nodes){
+        if(numNodes > 0){
+            GraphColorWorld::minGraphNodesPL->set(numNodes);
+            GraphColorWorld::maxGraphNodesPL->set(numNodes);
+        }
+        std::unique_ptr<GraphColorWorld> world;
+        {
+            QuietCout quiet;
+            world.reset(new GraphColorWorld(nullptr));
+        }
+        for(double density : config.densities){
+            if(config.graphFile.empty())
+                world->G.randomize(numNodes, density, GraphGenerators::GNP, 2.5, config.seed);
+            else
+                density = world->G.edge_count / std::max(1.0, world->G.node_count * (world->G.node_count - 1) / 2.0);
+            for(int lifetime : config.lifetimes){
+                world->agentLifetime = lifetime;
+                for(auto& brainType : config.brains)
+                    run(*world, config, brainType, density);
+            }
+        }
+        QuietCout quiet;
+        world.reset();
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Checks that a churned graph is the graph rebuilt from scratch: rounds of random churn are
+// applied to a Graph (patching its topology in place, as the world does) and to a shared
+// topology (copied), and each result is compared against a topology built from the edge
+// list with the same changes made: rows, degrees, max_degree, bit matrix, directed entries,
+// binary image and conflict counts.
+// Build and run with "make test_graph_churn" (needs the MABE submodule); exits 1 on a mismatch.
+
+#include <cstdio>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "World/GraphColorWorld/Graph.h"
+
+using EdgeSet = std::set<std::pair<uint32_t, uint32_t>>;
+
+static int failures = 0;
+
+static void expect(bool ok, const std::string& what, const std::string& where){
+    if(!ok && failures++ < 20)
+        std::printf("FAIL %s: %s\n", where.c_str(), what.c_str());
+}
+
+static std::string binary_image(const GraphTopology& topo){
+    std::ostringstream out;
+    GraphIO::write_binary(topo, out);
+    return out.str();
+}
+
+static void compare_topologies(const GraphTopology& topo, const GraphTopology& ref, const std::string& where){
+    expect(topo.node_count == ref.node_count, "node_count", where);
+    expect(topo.edge_count == ref.edge_count, "edge_count", where);
+    expect(topo.max_degree == ref.max_degree, "max_degree", where);
+    expect(topo.max_degree == topo.get_max_degree(), "max_degree of the rows", where);
+    expect(topo.num_directed_edges() == ref.num_directed_edges(), "num_directed_edges", where);
+    expect(topo.adj_bits == ref.adj_bits, "bit matrix", where);
+    for(size_t n = 0; n < ref.node_count; ++n){
+        std::vector<uint32_t> row(topo.neighbors_begin(n), topo.neighbors_end(n));
+        std::vector<uint32_t> ref_row(ref.neighbors_begin(n), ref.neighbors_end(n));
+        expect(row == ref_row, "row " + std::to_string(n), where);
+    }
+    for(size_t entry = 0; entry < ref.num_directed_edges(); ++entry)
+        expect(topo.directed_entry(entry) == ref.directed_entry(entry), "directed entry " + std::to_string(entry), where);
+    expect(binary_image(topo) == binary_image(ref), "binary image", where);
+}
+
+// ref on topo, with G's colors and its conflicts counted from scratch
+static void compare_graphs(const Graph& G, const std::shared_ptr<const GraphTopology>& topo, const std::string& where){
+    Graph ref;
+    ref.set_topology(topo);
+    std::vector<uint32_t> words(G.node_count);
+    for(size_t n = 0; n < G.node_count; ++n)
+        words[n] = G.num_color_bits > 0 ? G.color_bits[n] << (32 - G.num_color_bits) : 0;
+    ref.reset_colors(G.num_color_bits, words.data());
+    expect(G.edge_count == ref.edge_count && G.max_degree == ref.max_degree, "graph counts", where);
+    expect(G.colors == ref.colors, "colors", where);
+    expect(G.node_conflicts == ref.node_conflicts, "node conflicts", where);
+    expect(G.conflict_count == ref.conflict_count, "conflict count", where);
+}
+
+static void run(const std::string& name, GraphGenerators::Type type, size_t num_nodes, double edge_chance,
+                GraphTopology::BitsetPolicy policy, double edge_churn, double node_churn, size_t rounds){
+    GraphGenerators::EdgeList edges = GraphGenerators::generate(type, num_nodes, edge_chance, 2.5, 7);
+    EdgeSet edge_set;
+    for(auto& edge : edges)
+        edge_set.insert(std::make_pair(std::min(edge.first, edge.second), std::max(edge.first, edge.second)));
+
+    Graph G;
+    G.bitset_policy = policy;
+    auto initial = std::make_shared<GraphTopology>(num_nodes);
+    initial->build(edges, policy);
+    G.set_topology(initial);
+    initial = nullptr;
+    std::mt19937 rng(11);
+    G.reset_colors(3, rng);
+    std::shared_ptr<const GraphTopology> copied = G.topology;
+    copied = GraphChurn::apply(*copied, GraphChurn::Diff(), policy);
+
+    for(size_t round = 0; round < rounds; ++round){
+        std::string where = name + " round " + std::to_string(round);
+        GraphChurn::Diff diff = GraphChurn::random_churn(*G.topology, edge_churn, node_churn, 1000 + round);
+        GraphChurn::Diff copied_diff = GraphChurn::random_churn(*copied, edge_churn, node_churn, 1000 + round);
+        expect(diff.removed == copied_diff.removed && diff.added == copied_diff.added,
+               "same churn drawn from the patched and the copied topology", where);
+        for(auto& edge : diff.removed)
+            edge_set.erase(edge);
+        for(auto& edge : diff.added)
+            edge_set.insert(edge);
+
+        const GraphTopology* before = G.topology.get();
+        G.apply_diff(diff);
+        expect(G.topology.get() == before, "patched in place", where);
+        copied = GraphChurn::apply(*copied, diff, policy);
+        // Some colors change too, so conflicts are counted through both changes
+        G.set_color_bits(round % num_nodes, (uint32_t)rng() & 7);
+
+        GraphGenerators::EdgeList rebuilt_edges(edge_set.begin(), edge_set.end());
+        auto rebuilt = std::make_shared<GraphTopology>(num_nodes);
+        rebuilt->build(rebuilt_edges, policy);
+        compare_topologies(*G.topology, *rebuilt, where + " (in place)");
+        compare_topologies(*copied, *rebuilt, where + " (copied)");
+        compare_graphs(G, rebuilt, where);
+    }
+}
+
+int main(){
+    run("gnp", GraphGenerators::GNP, 500, 0.02, GraphTopology::BITSET_NEVER, 0.05, 0.01, 60);
+    run("gnp with bit matrix", GraphGenerators::GNP, 200, 0.3, GraphTopology::BITSET_ALWAYS, 0.1, 0.02, 30);
+    run("power law", GraphGenerators::POWER_LAW, 800, 0.01, GraphTopology::BITSET_AUTO, 0.2, 0.05, 40);
+    run("regular", GraphGenerators::REGULAR, 300, 0.02, GraphTopology::BITSET_NEVER, 0.5, 0.1, 40);
+    run("small", GraphGenerators::GNP, 5, 0.5, GraphTopology::BITSET_AUTO, 0.5, 0.4, 40);
+    std::printf(failures == 0 ? "All churned graphs match their rebuilds\n" : "%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+// Converts a graph in any format GraphIO reads (DIMACS .col, METIS .graph/.metis,
+// Matrix Market .mtx, or the Graphs/*.txt edge list) into the binary format that
+// WORLD_GRAPH_COLOR-graphFile can memory-map.
+// Build with "make convert_graph"; usage: convert_graph <input> <output.gcg>
+
+#include <chrono>
+#include <iostream>
+#include "../World/GraphColorWorld/GraphIO.h"
+
+int main(int argc, char** argv){
+    if(argc != 3){
+        std::cout << "Usage: " << argv[0] << " <input graph> <output.gcg>" << std::endl;
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto topo = GraphIO::load(argv[1], GraphTopology::BITSET_NEVER);
+    double parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    GraphIO::save_binary(*topo, argv[2]);
+    std::cout << argv[1] << ": " << topo->node_count << " nodes, " << topo->edge_count
+              << " edges, max degree " << topo->max_degree << " (read in " << parse_seconds
+              << "s) -> " << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Prints columns of a metrics file (WORLD_GRAPH_COLOR-metricsOutput binary or both) as CSV,
+// decoding only the columns asked for, e.g. to load just the scores into the notebook.
+// Build with "make dump_metrics"; usage: dump_metrics <metrics.gcm> [column ...]
+// With no columns, lists the file's columns and row count.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../World/GraphColorWorld/MetricsLog.h"
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        std::printf("Usage: %s <metrics.gcm> [column ...]\n", argv[0]);
+        return 1;
+    }
+    MetricsReader reader(argv[1]);
+    if(argc == 2){
+        size_t rows = reader.columns.empty() ? 0 : reader.read_raw(0).size();
+        for(auto& column : reader.columns)
+            std::printf("%s,%s\n", column.name.c_str(), column.type == Metrics::INT64 ? "int64" : "double");
+        std::printf("%zu rows\n", rows);
+        return 0;
+    }
+    std::vector<std::vector<int64_t>> ints(argc - 2);
+    std::vector<std::vector<double>> doubles(argc - 2);
+    size_t rows = 0;
+    for(int c = 2; c < argc; ++c){
+        int index = reader.find(argv[c]);
+        if(index < 0){
+            std::printf("No column %s in %s\n", argv[c], argv[1]);
+            return 1;
+        }
+        if(reader.columns[index].type == Metrics::INT64)
+            ints[c - 2] = reader.read_int(argv[c]);
+        else
+            doubles[c - 2] = reader.read_double(argv[c]);
+        rows = std::max(ints[c - 2].size(), doubles[c - 2].size());
+        std::printf("%s%s", c > 2 ? "," : "", argv[c]);
+    }
+    std::printf("\n");
+    for(size_t row = 0; row < rows; ++row){
+        for(int c = 2; c < argc; ++c){
+            if(c > 2)
+                std::printf(",");
+            if(!ints[c - 2].empty())
+                std::printf("%lld", (long long)ints[c - 2][row]);
+            else
+                std::printf("%.17g", doubles[c - 2][row]);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+// Local includes
+#include "./GraphTopology.h"
+#include "./GraphAnalysis.h"
+
+// Native graph coloring algorithms, as baselines for evolved brains and as an oracle for
+// how many colors a graph really needs.
+//
+// The distributed algorithms run in the world's synchronous tick model: each round,
+// every node decides from what its neighbors had at the end of the previous round, and
+// a value a node shares reaches its neighbors one round later. A message is one value
+// sent along one edge.
+namespace ColoringEngines{
+    struct Result{
+        std::string engine;
+        std::vector<uint32_t> colors;
+        size_t num_colors = 0;
+        bool optimal = false;       // num_colors is proven to be the chromatic number
+        size_t rounds = 0;          // Synchronous rounds (distributed engines only)
+        size_t messages = 0;        // Values sent along edges (distributed engines only)
+        size_t search_nodes = 0;    // Partial colorings explored (exact engine only)
+        double seconds = 0;
+    };
+
+    inline bool is_valid(const GraphTopology& topo, const std::vector<uint32_t>& colors){
+        for(size_t n = 0; n < topo.node_count; ++n){
+            if(colors[n] == GraphAnalysis::uncolored)
+                return false;
+            for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m){
+                if(*m != n && colors[*m] == colors[n])
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // Size of a clique found greedily from the highest-degree nodes, a lower bound on the
+    // chromatic number
+    inline size_t greedy_clique_size(const GraphTopology& topo){
+        std::vector<uint32_t> order(topo.node_count);
+        for(size_t n = 0; n < topo.node_count; ++n)
+            order[n] = n;
+        std::sort(order.begin(), order.end(), [&topo](uint32_t a, uint32_t b){
+            return topo.degree(a) > topo.degree(b);
+        });
+        size_t best = topo.node_count > 0 ? 1 : 0;
+        // Grow a clique from each of the first few nodes
+        for(size_t start = 0; start < std::min((size_t)16, order.size()); ++start){
+            std::vector<uint32_t> clique = {order[start]};
+            for(uint32_t n : order){
+                bool joins = n != order[start];
+                for(size_t i = 0; joins && i < clique.size(); ++i)
+                    joins = topo.check_neighbors(n, clique[i]);
+                if(joins)
+                    clique.push_back(n);
+            }
+            best = std::max(best, clique.size());
+        }
+        return best;
+    }
+
+    template<class Function>
+    Result timed(const std::string& engine, Function run){
+        auto start = std::chrono::steady_clock::now();
+        Result result;
+        run(result);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.engine = engine;
+        result.num_colors = GraphAnalysis::count_colors(result.colors);
+        return result;
+    }
+
+    inline Result greedy(const GraphTopology& topo){
+        return timed("greedy", [&](Result& result){
+            result.colors = GraphAnalysis::greedy_coloring(topo);
+        });
+    }
+
+    inline Result dsatur(const GraphTopology& topo){
+        return timed("dsatur", [&](Result& result){
+            result.colors = GraphAnalysis::dsatur_coloring(topo);
+        });
+    }
+
+    // DSatur-ordered branch and bound (Brelaz 1979), starting from the DSatur
+    // coloring and stopping early if a coloring matches the clique lower bound. Gives up
+    // after max_search_nodes partial colorings, returning the best coloring found so far
+    // with optimal = false.
+    inline Result exact(const GraphTopology& topo, size_t max_search_nodes){
+        return timed("exact", [&](Result& result){
+            size_t num_nodes = topo.node_count;
+            result.colors = GraphAnalysis::dsatur_coloring(topo);
+            size_t best = GraphAnalysis::count_colors(result.colors);
+            size_t lower_bound = greedy_clique_size(topo);
+            if(best <= lower_bound || num_nodes == 0){
+                result.optimal = true;
+                return;
+            }
+            // neighbor_count[n * stride + c]: neighbors of n with color c
+            size_t stride = best;
+            std::vector<uint32_t> neighbor_count(num_nodes * stride, 0);
+            std::vector<uint32_t> saturation(num_nodes, 0);
+            std::vector<uint32_t> colors(num_nodes, GraphAnalysis::uncolored);
+            // Uncolored nodes as (saturation, degree, node); the last is the next to color
+            std::set<std::tuple<uint32_t, size_t, uint32_t>> queue;
+            for(size_t n = 0; n < num_nodes; ++n)
+                queue.insert(std::make_tuple((uint32_t)0, topo.degree(n), (uint32_t)n));
+            auto change_saturation = [&](uint32_t n, int delta){
+                if(colors[n] == GraphAnalysis::uncolored){
+                    queue.erase(std::make_tuple(saturation[n], topo.degree(n), n));
+                    queue.insert(std::make_tuple(saturation[n] + delta, topo.degree(n), n));
+                }
+                saturation[n] += delta;
+            };
+            auto assign = [&](uint32_t n, uint32_t c){
+                queue.erase(std::make_tuple(saturation[n], topo.degree(n), n));
+                colors[n] = c;
+                for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m){
+                    if(neighbor_count[*m * stride + c]++ == 0)
+                        change_saturation(*m, 1);
+                }
+            };
+            auto unassign = [&](uint32_t n){
+                uint32_t c = colors[n];
+                colors[n] = GraphAnalysis::uncolored;
+                queue.insert(std::make_tuple(saturation[n], topo.degree(n), n));
+                for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m){
+                    if(--neighbor_count[*m * stride + c] == 0)
+                        change_saturation(*m, -1);
+                }
+            };
+            auto pick_node = [&](){
+                return std::get<2>(*std::prev(queue.end()));
+            };
+
+            // Explicit stack (graphs can be deeper than the call stack): one frame per colored node
+            struct Frame{
+                uint32_t node;
+                uint32_t next_color;    // Next color to try for node
+                uint32_t colors_before; // Colors in use before node was colored
+            };
+            std::vector<Frame> stack;
+            stack.push_back({pick_node(), 0, 0});
+            bool exhausted = true;
+            while(!stack.empty()){
+                Frame& frame = stack.back();
+                if(colors[frame.node] != GraphAnalysis::uncolored)
+                    unassign(frame.node);
+                // Only colors already in use, or one new one, and never as many as the best so far
+                uint32_t limit = std::min(frame.colors_before + 1, (uint32_t)best - 1);
+                uint32_t c = frame.next_color;
+                while(c < limit && neighbor_count[frame.node * stride + c] > 0)
+                    ++c;
+                if(c >= limit){
+                    stack.pop_back();
+                    continue;
+                }
+                if(++result.search_nodes > max_search_nodes){
+                    exhausted = false;
+                    break;
+                }
+                frame.next_color = c + 1;
+                assign(frame.node, c);
+                uint32_t colors_now = std::max(frame.colors_before, c + 1);
+                if(stack.size() == num_nodes){
+                    // Complete coloring with fewer colors than the best so far
+                    best = colors_now;
+                    result.colors = colors;
+                    if(best <= lower_bound)
+                        break;
+                    continue;
+                }
+                stack.push_back({pick_node(), 0, colors_now});
+            }
+            result.optimal = exhausted;
+        });
+    }
+
+    // Shared by the distributed engines: each round, the uncolored nodes that beat all
+    // their uncolored neighbors' priorities take the smallest color no neighbor has
+    template<class Priorities>
+    void color_by_rounds(const GraphTopology& topo, Result& result, Priorities next_priorities){
+        size_t num_nodes = topo.node_count;
+        result.colors.assign(num_nodes, GraphAnalysis::uncolored);
+        std::vector<uint64_t> priority(num_nodes);
+        std::vector<uint32_t> winners;
+        std::vector<size_t> used_by(topo.max_degree + 2, (size_t)-1);
+        std::vector<uint32_t> uncolored(num_nodes);
+        for(size_t n = 0; n < num_nodes; ++n)
+            uncolored[n] = n;
+        auto beats = [&priority](uint32_t a, uint32_t b){
+            return priority[a] > priority[b] || (priority[a] == priority[b] && a > b);
+        };
+        while(!uncolored.empty()){
+            ++result.rounds;
+            result.messages += next_priorities(uncolored, priority);
+            winners.clear();
+            for(uint32_t n : uncolored){
+                bool wins = true;
+                for(const uint32_t* m = topo.neighbors_begin(n); wins && m != topo.neighbors_end(n); ++m){
+                    if(*m != n && result.colors[*m] == GraphAnalysis::uncolored && beats(*m, n))
+                        wins = false;
+                }
+                if(wins)
+                    winners.push_back(n);
+            }
+            // Winners are never neighbors, so they can all take colors at once
+            for(uint32_t n : winners){
+                for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m){
+                    if(result.colors[*m] != GraphAnalysis::uncolored)
+                        used_by[result.colors[*m]] = n;
+                }
+                uint32_t color = 0;
+                while(used_by[color] == n)
+                    ++color;
+                result.colors[n] = color;
+                result.messages += topo.degree(n); // Announce the new color
+            }
+            uncolored.erase(std::remove_if(uncolored.begin(), uncolored.end(), [&result](uint32_t n){
+                return result.colors[n] != GraphAnalysis::uncolored;
+            }), uncolored.end());
+        }
+    }
+
+    // Luby-style: every uncolored node draws a fresh random priority each round and sends it
+    // to its neighbors
+    inline Result luby(const GraphTopology& topo, uint64_t seed){
+        return timed("luby", [&](Result& result){
+            std::mt19937_64 rng(seed);
+            color_by_rounds(topo, result, [&](const std::vector<uint32_t>& uncolored, std::vector<uint64_t>& priority){
+                size_t messages = 0;
+                for(uint32_t n : uncolored){
+                    priority[n] = rng();
+                    messages += topo.degree(n);
+                }
+                return messages;
+            });
+        });
+    }
+
+    // Jones-Plassmann: random priorities are drawn and exchanged once, then each node waits
+    // for its higher-priority neighbors to be colored
+    inline Result jones_plassmann(const GraphTopology& topo, uint64_t seed){
+        return timed("jones_plassmann", [&](Result& result){
+            std::mt19937_64 rng(seed);
+            bool drawn = false;
+            color_by_rounds(topo, result, [&](const std::vector<uint32_t>& uncolored, std::vector<uint64_t>& priority){
+                if(drawn)
+                    return (size_t)0;
+                drawn = true;
+                size_t messages = 0;
+                for(uint32_t n : uncolored){
+                    priority[n] = rng();
+                    messages += topo.degree(n);
+                }
+                return messages;
+            });
+        });
+    }
+}
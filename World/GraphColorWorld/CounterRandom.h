@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Counter-based random numbers: Philox4x32-10 (Salmon et al., "Parallel random numbers:
+// as easy as 1, 2, 3", SC 2011). Each 128-bit counter maps to four random words under a
+// 64-bit key, with no state carried between calls, so any word of any stream can be
+// computed directly and blocks can be filled in any order (or in parallel) with the same
+// result.
+namespace CounterRandom{
+    // Four random words for (counter, key)
+    inline void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]){
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for(int round = 0; round < 10; ++round){
+            uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+            uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c1 = (uint32_t)p1;
+            c3 = (uint32_t)p0;
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    // The words for one evaluation: keyed by (run key, generation), with the organism and
+    // eval in the high counter words. Each position (e.g., tick) is its own sequence of words.
+    class Stream{
+    public:
+        Stream(uint32_t run_key, uint32_t generation, uint32_t organism, uint32_t eval)
+            : key{run_key, generation}, organism(organism), eval(eval){}
+
+        // The first count words at position
+        void fill(uint32_t position, uint32_t* words, size_t count) const{
+            uint32_t block[4];
+            size_t full = count / 4;
+            for(size_t b = 0; b < full; ++b){
+                uint32_t counter[4] = {(uint32_t)b, position, eval, organism};
+                philox4x32(counter, key, words + 4 * b);
+            }
+            if(count % 4 != 0){
+                uint32_t counter[4] = {(uint32_t)full, position, eval, organism};
+                philox4x32(counter, key, block);
+                for(size_t i = 0; i < count % 4; ++i)
+                    words[4 * full + i] = block[i];
+            }
+        }
+
+    private:
+        uint32_t key[2];
+        uint32_t organism, eval;
+    };
+
+    // Fisher-Yates shuffle, with words[i] choosing the element swapped into slot i.
+    // Maps words to ranges by multiply-shift, which is biased by at most size / 2^32.
+    template<class T>
+    void shuffle(std::vector<T>& values, const uint32_t* words){
+        for(size_t i = values.size(); i > 1; --i){
+            size_t j = (size_t)(((uint64_t)words[i - 1] * i) >> 32);
+            std::swap(values[i - 1], values[j]);
+        }
+    }
+}
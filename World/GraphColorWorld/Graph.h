@@ -6,169 +6,262 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <random>
+#include <cstdint>
 // MABE includes
 #include "../../Utilities/Random.h"
 // Local includes
-#include "./Node.h"
+#include "./GraphTopology.h"
+#include "./GraphGenerators.h"
+#include "./GraphIO.h"
+#include "./GraphChurn.h"
 
+// A coloring over a GraphTopology. Copies of a Graph share the same read-only
+// topology, so each evaluation thread can own a Graph with its own colors.
+//
+// Each node's color is packed into one integer (color bit 0 is the most significant
+// bit), and the decoded color, reduced to [0, max_degree], is cached next to it.
+// The cache is only refreshed by set_color/set_color_by_index/reset_colors.
+//
+// The graph also keeps a running count of conflicts (neighbor pairs sharing a color),
+// updated in O(degree) whenever a node's decoded color changes, so checking the
+// coloring and scoring it are O(1).
 class Graph{
 public: 
-    std::vector<Node> nodes;
-    std::vector<std::set<size_t>> adj_vec;
+    std::shared_ptr<const GraphTopology> topology;
+    std::vector<uint32_t> color_bits;   // Raw color of each node, as set by the brains
+    std::vector<uint32_t> colors;       // color_bits[n] % (max_degree + 1)
+    std::vector<uint32_t> node_conflicts; // Neighbors of n that share n's color
+    size_t conflict_count;              // Sum of node_conflicts, i.e. each conflicting edge twice
+    size_t num_color_bits;
     size_t node_count, edge_count, max_degree;
+    GraphTopology::BitsetPolicy bitset_policy = GraphTopology::BITSET_AUTO;
     
     Graph(){
         node_count = 0;
         edge_count = 0;
+        max_degree = 0;
+        num_color_bits = 0;
+        conflict_count = 0;
+        topology = std::make_shared<GraphTopology>();
     }
 
-    void randomize(size_t num_nodes, double edge_chance){
-        node_count = num_nodes; 
-        edge_count = 0;
-        nodes.clear();
-        adj_vec.clear();
-        for(size_t n = 0; n < node_count; ++n){
-            nodes.push_back(Node(n));
+    void set_topology(std::shared_ptr<const GraphTopology> topo){
+        topology = topo;
+        node_count = topology->node_count;
+        edge_count = topology->edge_count;
+        max_degree = topology->max_degree;
+        color_bits.assign(node_count, 0);
+        colors.assign(node_count, 0);
+        recount_conflicts();
+    }
+
+    // Switches to the topology with diff applied, keeping the colors; the topology is patched
+    // in place if this graph is its only user (see GraphChurn::apply). Conflicts are only
+    // updated along the changed edges, and around nodes whose color changes with max_degree.
+    void apply_diff(const GraphChurn::Diff& diff){
+        topology = GraphChurn::apply(std::move(topology), diff, bitset_policy);
+        edge_count = topology->edge_count;
+        for(auto& edge : diff.removed)
+            count_edge_conflict(edge.first, edge.second, -1);
+        for(auto& edge : diff.added)
+            count_edge_conflict(edge.first, edge.second, 1);
+        if(topology->max_degree != max_degree){
+            max_degree = topology->max_degree;
+            for(size_t n = 0; n < node_count; ++n)
+                store_color(n, color_bits[n]);
         }
-        adj_vec.resize(node_count);
-        size_t a, b;
-        double rand_pct;
-        for(size_t a = 0; a < node_count - 1; ++a){
-            for(size_t b = a + 1; b < node_count - 1; ++b){ 
-                rand_pct = Random::getDouble(0,1); // In [0, 1) which should be fine
-                if(rand_pct <= edge_chance){
-                    adj_vec[a].insert(b);
-                    adj_vec[b].insert(a);
-                    ++edge_count;
-                }
-            }
-        } 
-        max_degree = get_max_degree();
+    }
+
+    // Lets go of the topology (the color arrays keep their memory), e.g. so the graph that
+    // owns it can patch it
+    void release_topology(){
+        set_topology(std::make_shared<GraphTopology>());
+    }
+
+    void randomize(size_t num_nodes, double edge_chance, 
+                   GraphGenerators::Type type = GraphGenerators::LEGACY, double power_law_exponent = 2.5,
+                   uint64_t seed = 0){
+        set_topology(make_random_topology(num_nodes, edge_chance, type, power_law_exponent, seed));
+    }
+
+    // Builds a random graph without switching this graph over to it
+    std::shared_ptr<const GraphTopology> make_random_topology(size_t num_nodes, double edge_chance, 
+            GraphGenerators::Type type = GraphGenerators::LEGACY, double power_law_exponent = 2.5,
+            uint64_t seed = 0) const{
+        auto topo = std::make_shared<GraphTopology>(num_nodes);
+        auto edges = GraphGenerators::generate(type, num_nodes, edge_chance, power_law_exponent, seed);
+        topo->build(edges, bitset_policy);
+        return topo;
     }
 
     bool check_graph_coloring(){
-        for(size_t n = 0; n < node_count; ++n){
-            for(size_t m : adj_vec[n]){
-                if(get_color(n) == get_color(m)){
-                    return false;
-                }
-            }
-        }
-        return true;
+        return conflict_count == 0;
     }
 
     double get_graph_score(){
         double score = edge_count * 2;
+        score -= conflict_count;
+        return score*100/(1 + edge_count * 2);
+    }
+
+    // Rebuilds the conflict counts from scratch with a full pass over the edges
+    void recount_conflicts(){
+        node_conflicts.assign(node_count, 0);
+        conflict_count = 0;
         for(size_t n = 0; n < node_count; ++n){
-            for(size_t m : adj_vec[n]){
-                if(get_color(n) == get_color(m)){
-                    score -= 1.0;
+            uint32_t color = colors[n];
+            for(const uint32_t* m = topology->neighbors_begin(n); m != topology->neighbors_end(n); ++m){
+                if(color == colors[*m]){
+                    ++node_conflicts[n];
                 }
             }
+            conflict_count += node_conflicts[n];
         }
-        return score*100/(1 + edge_count * 2);
     }
 
     size_t get_num_colors(){
         std::set<size_t> color_set;
-        for(size_t n = 0; n < nodes.size(); ++n)
-            color_set.insert(get_color(n));
+        for(size_t n = 0; n < node_count; ++n)
+            color_set.insert(colors[n]);
         return color_set.size();
     } 
 
     size_t get_max_degree(){
-        size_t cur_max = 0;
-        for(size_t n = 0; n < nodes.size(); ++n){
-            if(adj_vec[n].size() > cur_max)
-                cur_max = adj_vec[n].size();
-        }
-        return cur_max;
+        return topology->get_max_degree();
     }
 
+    // Reads any format GraphIO understands (binary graphs are memory-mapped, not copied)
     void load_from_file(std::string filename){
-        std::ifstream fp;
-        fp.open(filename, std::ios::in);
-        fp >> node_count >> edge_count;
-        for(size_t n = 0; n < node_count; ++n){
-            nodes.push_back(Node(n));
-        }
-        adj_vec.resize(node_count);
-        size_t a, b;
-        for(size_t i = 0; i < edge_count; ++i){
-            fp >> a >> b;
-            adj_vec[a].insert(b);
-            adj_vec[b].insert(a);
-        } 
-        fp.close(); 
+        set_topology(GraphIO::load(filename, bitset_policy));
     }
     
     void reset_colors(size_t num_bits){
-        for(size_t n = 0; n < nodes.size(); ++n){
-            nodes[n].color = std::vector<size_t>(num_bits, 0);
+        num_color_bits = num_bits;
+        for(size_t n = 0; n < node_count; ++n){
+            uint32_t bits = 0;
             for(size_t i = 0; i < num_bits; ++i){// Randomize each bit
-                nodes[n].color[i] = (size_t)(Random::getDouble(0,1) < 0.5);
+                bits = (bits << 1) | (uint32_t)(Random::getDouble(0,1) < 0.5);
             }
+            color_bits[n] = bits;
+            colors[n] = bits % (max_degree + 1);
         }
+        recount_conflicts();
+    }
+
+    // Same as above, but draws from the given generator instead of MABE's shared one
+    void reset_colors(size_t num_bits, std::mt19937& rng){
+        num_color_bits = num_bits;
+        for(size_t n = 0; n < node_count; ++n){
+            uint32_t bits = 0;
+            for(size_t i = 0; i < num_bits; ++i){// Randomize each bit
+                bits = (bits << 1) | (uint32_t)(rng() & 1);
+            }
+            color_bits[n] = bits;
+            colors[n] = bits % (max_degree + 1);
+        }
+        recount_conflicts();
+    }
+
+    // Same as above, but takes each node's bits from the top of words[n] (num_bits <= 32)
+    void reset_colors(size_t num_bits, const uint32_t* words){
+        num_color_bits = num_bits;
+        for(size_t n = 0; n < node_count; ++n){
+            uint32_t bits = num_bits > 0 ? words[n] >> (32 - num_bits) : 0;
+            color_bits[n] = bits;
+            colors[n] = bits % (max_degree + 1);
+        }
+        recount_conflicts();
     }
  
     bool check_neighbors(size_t a, size_t b){
-        if(adj_vec[a].find(b) != adj_vec[a].end())
-            return true;
-        // Just in case we switch to directed graphs
-        if(adj_vec[b].find(a) != adj_vec[b].end())
-            return true;
-        return false;
+        return topology->check_neighbors(a, b);
     }
     
     void set_color(size_t node_id, std::vector<size_t> color){
-        if(node_id >= nodes.size()){
+        if(node_id >= node_count){
             std::cout << "Error! Tried to assign color to node " << node_id << ", but "
-                      << " node list has only " << nodes.size() << "nodes!" << std::endl;
+                      << " node list has only " << node_count << "nodes!" << std::endl;
             exit(-1);
         }
-        nodes[node_id].color = color;
+        num_color_bits = color.size();
+        uint32_t bits = 0;
+        for(size_t i = 0; i < color.size(); ++i)
+            bits = (bits << 1) | (uint32_t)(color[i] != 0);
+        store_color(node_id, bits);
+    }
+
+    // Sets all of a node's color bits at once (bit 0 of the color is the most significant bit of bits)
+    void set_color_bits(size_t node_id, uint32_t bits){
+        store_color(node_id, bits);
     }
 
     void set_color_by_index(size_t node_id, size_t idx, size_t val){
-        if(node_id >= nodes.size()){
+        if(node_id >= node_count){
             std::cout << "Error! Tried to assign color to node " << node_id << ", but "
-                      << "node list has only " << nodes.size() << " nodes!" << std::endl;
+                      << "node list has only " << node_count << " nodes!" << std::endl;
             exit(-1);
         }
-        //This isn't safe, but I want sppeeeeeeedddd
-        nodes[node_id].color[idx] = val;
+        uint32_t mask = (uint32_t)1 << (num_color_bits - 1 - idx);
+        if(val)
+            store_color(node_id, color_bits[node_id] | mask);
+        else
+            store_color(node_id, color_bits[node_id] & ~mask);
     }
 
     size_t get_color_at_index(size_t node_id, size_t idx){
-        return nodes[node_id].color[idx];
+        return (color_bits[node_id] >> (num_color_bits - 1 - idx)) & 1;
     }
     
     size_t get_color(size_t n){
-        return nodes[n].get_uint_color() % (max_degree + 1);
+        return colors[n];
     }
 
     void print_colors(){
-        for(size_t n = 0; n < nodes.size(); ++n){
+        for(size_t n = 0; n < node_count; ++n){
             std::cout << n << ":  ";
             std::cout << get_color(n) << " ";
             std::cout << std::endl;
         }
     }
     std::string get_csv_string(){
-        std::ostringstream oss;
-        oss << node_count;
-        oss << ",";
-        oss << edge_count;
-        oss << ",";
-        oss << "\"[";
-        for(size_t a = 0; a < node_count; ++a){
-            for(size_t b = 0; b < node_count; ++b){
-                if(a != 0 || b != 0)
-                    oss << ",";
-                oss << (size_t)(adj_vec[a].find(b) != adj_vec[a].end());
+        return GraphIO::to_matrix_csv(*topology);
+    }
+
+private:
+    // Adds (sign 1) or removes (sign -1) edge (a, b)'s conflict, if its ends share a color
+    void count_edge_conflict(uint32_t a, uint32_t b, int sign){
+        if(colors[a] != colors[b])
+            return;
+        node_conflicts[a] += sign;
+        conflict_count += sign;
+        if(a != b){ // A self loop is one entry of its row
+            node_conflicts[b] += sign;
+            conflict_count += sign;
+        }
+    }
+
+    void store_color(size_t n, uint32_t bits){
+        color_bits[n] = bits;
+        uint32_t old_color = colors[n];
+        uint32_t new_color = bits % (max_degree + 1);
+        if(new_color == old_color)
+            return;
+        colors[n] = new_color;
+        for(const uint32_t* m = topology->neighbors_begin(n); m != topology->neighbors_end(n); ++m){
+            if(*m == n) // A self loop conflicts with every color
+                continue;
+            if(colors[*m] == old_color){
+                --node_conflicts[n];
+                --node_conflicts[*m];
+                conflict_count -= 2;
+            }
+            else if(colors[*m] == new_color){
+                ++node_conflicts[n];
+                ++node_conflicts[*m];
+                conflict_count += 2;
             }
         }
-        oss << "]\"";
-        return oss.str();
     }
 };
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <tuple>
+#include <vector>
+// Local includes
+#include "./GraphTopology.h"
+
+// Properties of a graph worth computing once per graph rather than once per evaluation:
+// its degeneracy and the number of colors classic sequential heuristics need. Each
+// heuristic's count is an upper bound on the chromatic number, as is degeneracy + 1.
+namespace GraphAnalysis{
+    const uint32_t uncolored = (uint32_t)-1;
+
+    // Largest k such that the graph has a k-core, via the O(N + E) bucket algorithm of
+    // Batagelj & Zaversnik (2003)
+    inline size_t degeneracy(const GraphTopology& topo){
+        size_t num_nodes = topo.node_count;
+        if(num_nodes == 0)
+            return 0;
+        size_t max_degree = topo.max_degree;
+        std::vector<size_t> degree(num_nodes), position(num_nodes), order(num_nodes);
+        std::vector<size_t> bin_start(max_degree + 1, 0);
+        for(size_t n = 0; n < num_nodes; ++n){
+            degree[n] = topo.degree(n);
+            ++bin_start[degree[n]];
+        }
+        size_t start = 0;
+        for(size_t d = 0; d <= max_degree; ++d){
+            size_t count = bin_start[d];
+            bin_start[d] = start;
+            start += count;
+        }
+        for(size_t n = 0; n < num_nodes; ++n){
+            position[n] = bin_start[degree[n]]++;
+            order[position[n]] = n;
+        }
+        for(size_t d = max_degree; d > 0; --d)
+            bin_start[d] = bin_start[d - 1];
+        bin_start[0] = 0;
+
+        size_t result = 0;
+        for(size_t i = 0; i < num_nodes; ++i){
+            size_t n = order[i];
+            result = std::max(result, degree[n]);
+            for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m){
+                size_t u = *m;
+                if(degree[u] > degree[n]){
+                    // Move u to the front of its bin, then shrink the bin past it
+                    size_t du = degree[u];
+                    size_t w = order[bin_start[du]];
+                    if(u != w){
+                        std::swap(order[position[u]], order[bin_start[du]]);
+                        std::swap(position[u], position[w]);
+                    }
+                    ++bin_start[du];
+                    --degree[u];
+                }
+            }
+        }
+        return result;
+    }
+
+    // Colors nodes in index order, each with the smallest color its colored neighbors don't use
+    inline std::vector<uint32_t> greedy_coloring(const GraphTopology& topo){
+        std::vector<uint32_t> colors(topo.node_count, uncolored);
+        std::vector<size_t> used_by(topo.max_degree + 2, (size_t)-1); // Last node that saw each color
+        for(size_t n = 0; n < topo.node_count; ++n){
+            for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m){
+                if(colors[*m] != uncolored)
+                    used_by[colors[*m]] = n;
+            }
+            uint32_t color = 0;
+            while(used_by[color] == n)
+                ++color;
+            colors[n] = color;
+        }
+        return colors;
+    }
+
+    // Brelaz's DSatur: repeatedly colors the node with the most distinct colors among its
+    // neighbors (ties broken by degree), with the smallest color it can take
+    inline std::vector<uint32_t> dsatur_coloring(const GraphTopology& topo){
+        size_t num_nodes = topo.node_count;
+        std::vector<uint32_t> colors(num_nodes, uncolored);
+        std::vector<std::set<uint32_t>> neighbor_colors(num_nodes);
+        // (saturation, degree, node); the last element is the next node to color
+        std::set<std::tuple<size_t, size_t, uint32_t>> queue;
+        for(size_t n = 0; n < num_nodes; ++n)
+            queue.insert(std::make_tuple((size_t)0, topo.degree(n), (uint32_t)n));
+        while(!queue.empty()){
+            auto next = std::prev(queue.end());
+            uint32_t n = std::get<2>(*next);
+            queue.erase(next);
+            uint32_t color = 0;
+            for(uint32_t used : neighbor_colors[n]){
+                if(used != color)
+                    break;
+                ++color;
+            }
+            colors[n] = color;
+            for(const uint32_t* m = topo.neighbors_begin(n); m != topo.neighbors_end(n); ++m){
+                if(colors[*m] != uncolored || neighbor_colors[*m].count(color))
+                    continue;
+                queue.erase(std::make_tuple(neighbor_colors[*m].size(), topo.degree(*m), *m));
+                neighbor_colors[*m].insert(color);
+                queue.insert(std::make_tuple(neighbor_colors[*m].size(), topo.degree(*m), *m));
+            }
+            std::set<uint32_t>().swap(neighbor_colors[n]);
+        }
+        return colors;
+    }
+
+    inline size_t count_colors(const std::vector<uint32_t>& colors){
+        if(colors.empty())
+            return 0;
+        return *std::max_element(colors.begin(), colors.end()) + 1;
+    }
+}
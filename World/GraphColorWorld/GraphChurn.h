@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+// Local includes
+#include "./GraphTopology.h"
+#include "./GraphGenerators.h"
+
+// Dynamic graphs: small random changes to a topology, so each generation can be evaluated
+// on last generation's graph with a few edges rewired and a few nodes replaced, instead of
+// on an unrelated new graph.
+//
+// A change is described by a Diff (the undirected edges removed and added), which is all
+// that needs to be logged, and applied by merging it into the changed rows of the CSR
+// arrays. Nothing is regenerated and no edge list of the whole graph is sorted. A topology
+// nothing else shares is patched in place, so the cost is in the number of changes;
+// otherwise the arrays are copied first.
+namespace GraphChurn{
+    using EdgeList = GraphGenerators::EdgeList;
+
+    struct Diff{
+        EdgeList removed;                       // (a, b) with a <= b, each in the old topology
+        EdgeList added;                         // (a, b) with a <= b, none in the old topology
+        std::vector<uint32_t> replaced_nodes;   // Nodes that lost every edge and were reconnected
+
+        size_t memory_usage() const{
+            return sizeof(Diff) + (removed.capacity() + added.capacity()) * sizeof(EdgeList::value_type)
+                + replaced_nodes.capacity() * sizeof(uint32_t);
+        }
+    };
+
+    inline uint64_t edge_key(uint32_t a, uint32_t b){
+        if(a > b)
+            std::swap(a, b);
+        return ((uint64_t)a << 32) | b;
+    }
+
+    inline EdgeList sorted_edges(const std::unordered_set<uint64_t>& keys){
+        EdgeList edges;
+        edges.reserve(keys.size());
+        for(uint64_t key : keys)
+            edges.emplace_back((uint32_t)(key >> 32), (uint32_t)key);
+        std::sort(edges.begin(), edges.end());
+        return edges;
+    }
+
+    // A random change to topo: round(node_churn * N) nodes drop all their edges and are
+    // reconnected to as many random nodes as they had neighbors, then round(edge_churn * E)
+    // of the other edges are removed and the same number of random non-edges added.
+    // Fully determined by (topo, edge_churn, node_churn, seed).
+    inline Diff random_churn(const GraphTopology& topo, double edge_churn, double node_churn, uint64_t seed){
+        Diff diff;
+        size_t num_nodes = topo.node_count;
+        if(num_nodes < 2)
+            return diff;
+        GraphGenerators::SeededRandom rand(seed);
+        std::unordered_set<uint64_t> removed, added;
+        auto is_edge = [&](uint32_t a, uint32_t b){
+            uint64_t key = edge_key(a, b);
+            return added.count(key) > 0 || (topo.check_neighbors(a, b) && removed.count(key) == 0);
+        };
+        auto random_node = [&](){
+            return (uint32_t)rand.get_int(0, (int)num_nodes - 1);
+        };
+        // Adds an edge from a to a random node it is not connected to, unless that takes
+        // too long (a is connected to almost everything); rewiring an edge back is no change
+        auto add_random_edge = [&](uint32_t a){
+            for(size_t attempt = 0; attempt < 100; ++attempt){
+                uint32_t b = random_node();
+                if(b == a || is_edge(a, b) || removed.count(edge_key(a, b)) > 0)
+                    continue;
+                added.insert(edge_key(a, b));
+                return;
+            }
+        };
+
+        size_t num_replaced = std::min(num_nodes, (size_t)std::llround(node_churn * num_nodes));
+        std::unordered_set<uint32_t> replaced;
+        while(diff.replaced_nodes.size() < num_replaced){
+            uint32_t node = random_node();
+            if(replaced.insert(node).second)
+                diff.replaced_nodes.push_back(node);
+        }
+        for(uint32_t node : diff.replaced_nodes){
+            for(const uint32_t* n = topo.neighbors_begin(node); n != topo.neighbors_end(node); ++n)
+                removed.insert(edge_key(node, *n));
+        }
+        for(uint32_t node : diff.replaced_nodes){
+            size_t degree = topo.degree(node);
+            for(size_t e = 0; e < degree; ++e)
+                add_random_edge(node);
+        }
+
+        // An edge is picked through a random entry of the neighbor array, so every edge
+        // is equally likely; entries of removed edges are passed over
+        size_t num_rewired = std::min(topo.edge_count, (size_t)std::llround(edge_churn * topo.edge_count));
+        size_t num_directed = topo.num_directed_edges();
+        size_t rewired = 0;
+        for(size_t attempt = 0; rewired < num_rewired && attempt < 100 * num_rewired; ++attempt){
+            auto edge = topo.directed_entry((size_t)(rand.rng() % num_directed));
+            if(removed.insert(edge_key(edge.first, edge.second)).second)
+                ++rewired;
+        }
+        for(size_t e = 0; e < rewired; ++e)
+            add_random_edge(random_node());
+
+        diff.removed = sorted_edges(removed);
+        diff.added = sorted_edges(added);
+        return diff;
+    }
+
+    // The directed entries of edges, sorted by row
+    inline EdgeList directed_entries(const EdgeList& edges){
+        EdgeList entries;
+        entries.reserve(2 * edges.size());
+        for(auto& edge : edges){
+            entries.push_back(edge);
+            if(edge.first != edge.second)
+                entries.emplace_back(edge.second, edge.first);
+        }
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }
+
+    // topo with diff applied. Each row is merged with its sorted changes, so the result is
+    // already in CSR order; a bit matrix is copied from topo with only the changed bits
+    // flipped when the node count allows it.
+    inline std::shared_ptr<GraphTopology> apply(const GraphTopology& topo, const Diff& diff,
+                                                GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO){
+        size_t num_nodes = topo.node_count;
+        EdgeList removed = directed_entries(diff.removed);
+        EdgeList added = directed_entries(diff.added);
+
+        std::vector<uint64_t> offsets(num_nodes + 1, 0);
+        std::vector<uint32_t> neighbors(topo.num_directed_edges() - removed.size() + added.size());
+        size_t r = 0, a = 0, write = 0;
+        for(uint32_t node = 0; node < num_nodes; ++node){
+            offsets[node] = write;
+            for(const uint32_t* n = topo.neighbors_begin(node); n != topo.neighbors_end(node); ++n){
+                if(r < removed.size() && removed[r].first == node && removed[r].second == *n){
+                    ++r;
+                    continue;
+                }
+                while(a < added.size() && added[a].first == node && added[a].second < *n)
+                    neighbors[write++] = added[a++].second;
+                neighbors[write++] = *n;
+            }
+            while(a < added.size() && added[a].first == node)
+                neighbors[write++] = added[a++].second;
+        }
+        offsets[num_nodes] = write;
+
+        auto result = std::make_shared<GraphTopology>(num_nodes);
+        size_t edge_count = topo.edge_count - diff.removed.size() + diff.added.size();
+        bool flip_bits = !topo.adj_bits.empty() && policy != GraphTopology::BITSET_NEVER;
+        result->assign(std::move(offsets), std::move(neighbors), edge_count,
+                       flip_bits ? GraphTopology::BITSET_NEVER : policy);
+        if(flip_bits && result->wants_bitset(policy)){
+            result->words_per_row = topo.words_per_row;
+            result->adj_bits = topo.adj_bits;
+            for(const EdgeList* changes : {&removed, &added}){
+                for(auto& entry : *changes)
+                    result->adj_bits[entry.first * result->words_per_row + (entry.second >> 6)] ^= (uint64_t)1 << (entry.second & 63);
+            }
+        }
+        return result;
+    }
+
+    // topo with diff applied, patched in place when the caller's is the only reference to it
+    // (pass it with std::move), and otherwise copied as above
+    inline std::shared_ptr<const GraphTopology> apply(std::shared_ptr<const GraphTopology> topo, const Diff& diff,
+                                                      GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO){
+        if(topo.use_count() != 1)
+            return apply(*topo, diff, policy);
+        // Every topology is created non-const; this one is no longer shared, so it can change
+        size_t edge_count = topo->edge_count - diff.removed.size() + diff.added.size();
+        const_cast<GraphTopology&>(*topo).patch(directed_entries(diff.removed), directed_entries(diff.added),
+                                                edge_count, policy);
+        return topo;
+    }
+
+    // "[[a,b],[c,d],...]", the same edge list format GraphIO logs whole graphs in
+    inline std::string to_edge_list_string(const EdgeList& edges){
+        std::ostringstream ss;
+        ss << "[";
+        for(size_t e = 0; e < edges.size(); ++e)
+            ss << (e > 0 ? "," : "") << "[" << edges[e].first << "," << edges[e].second << "]";
+        ss << "]";
+        return ss.str();
+    }
+}
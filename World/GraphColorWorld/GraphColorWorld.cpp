@@ -11,11 +11,6 @@
 // Local includes
 #include "GraphColorWorld.h"
 
-// Used to shuffle a vector using the same random seed as MABE
-int randInt(int i){
-    return Random::getInt(0, i-1);
-}
-
 std::shared_ptr <ParameterLink<int>> GraphColorWorld::modePL = Parameters::register_parameter("WORLD_GRAPH_COLOR-mode", 0, "0 = bit outputs before adding, 1 = add outputs");
 std::shared_ptr <ParameterLink<int>> GraphColorWorld::evaluationsPerGenerationPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-evaluationsPerGeneration", 1, "Number of times to test each Genome per "
                                                                                                                                                                    "generation (useful with non-deterministic "
@@ -34,13 +29,40 @@ std::shared_ptr <ParameterLink<int>> GraphColorWorld::useSetColorVetoBitPL = Par
 
 std::shared_ptr <ParameterLink<int>> GraphColorWorld::maximumColorsPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-maximumColors",  -1, "Maximum number of colors to be considered a valid graph coloring. (-1 to match the number of nodes)");
 
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::messageQueueCapacityPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-messageQueueCapacity",  0, "Maximum number of messages waiting in each node's queue (0 = unbounded, as in older runs; the queues of an evaluation then use at most 64 * nodes * (agentLifetime + 1) bytes)");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::messageOverflowPolicyPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-messageOverflowPolicy",  (std::string)"dropNewest", "What happens to a message sent to a full queue (see messageQueueCapacity): dropNewest (the new message is lost) or dropOldest (the oldest waiting message is lost)");
+
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::deltaInputsPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-deltaInputs",  1, "If 1, the world remembers the inputs it last gave each node's brain and a delivered message (or the zeros of an empty delivery) only sets the inputs that differ. Results are unchanged for brains that keep their inputs between updates, as MABE's do; set 0 for brains that change their own inputs. (1 for yes, 0 for no)");
+
 std::shared_ptr <ParameterLink<int>> GraphColorWorld::minGraphNodesPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-minGraphNodes",  1, "Minimum number of nodes in each generated graph (inclusive)(Will error if <= 0)");
 std::shared_ptr <ParameterLink<int>> GraphColorWorld::maxGraphNodesPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-maxGraphNodes",  20, "Maximum number of nodes in each generated graph (inclusive) (Will error if <= 0 or <= minGraphNodes)");
 
 std::shared_ptr <ParameterLink<double>> GraphColorWorld::minEdgeChancePL = Parameters::register_parameter("WORLD_GRAPH_COLOR-minEdgeChance",  0.0, "Minimum chance an edge will be placed between any two nodes in generated graphs (i.e., 0 = no edges, 1 = fully connected, 0.5 roughly half of all pairs have an edge)(Will error if not 0 <= p <= 1)");
 std::shared_ptr <ParameterLink<double>> GraphColorWorld::maxEdgeChancePL = Parameters::register_parameter("WORLD_GRAPH_COLOR-maxEdgeChance",  1.0, "Maximum chance an edge will be placed between any two nodes in generated graphs (see minEdgeChance)(Will error if not 0 <= p <= 1 or p < minEdgeChance)");
 
-std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::graphOutputDirPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphOutputDir",  (std::string)"./", "Directory where graph.csv will be saved.");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::graphOutputDirPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphOutputDir",  (std::string)"./", "Directory where the graph log (graph.csv or graph.gcg) will be saved.");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::graphLogFormatPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphLogFormat",  (std::string)"matrix", "How each generation's graph is logged: matrix (graph.csv with the full N x N adjacency matrix, the original format read by the analysis notebooks), edges (graph.csv with an edge list; much smaller for large graphs), binary (graph.gcg, binary graphs back to back), seed (graph.csv with only the generator parameters and seed; not for the legacy generator), or none");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::graphLogBufferMBPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphLogBufferMB",  256, "Graphs are logged by a background thread; if the graphs waiting to be written hold more than this many MB, new ones are dropped instead of slowing evaluation");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::metricsOutputPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-metricsOutput",  (std::string)"dataMap", "Where per-evaluation metrics go: dataMap (appended to each organism's dataMap and written to MABE's pop/ave files, as in earlier versions), binary (one row per evaluation in the columnar metrics.gcm in graphOutputDir; only score is kept in the dataMap, for selection), or both. Read metrics.gcm with MetricsReader or dump_metrics.");
+
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::graphGeneratorPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphGenerator",  (std::string)"legacy", "Family of random graphs generated each generation: legacy (the original O(N^2) generator, drawing from MABE's generator; evaluations draw from it differently than in older versions, so only the first generation's graph matches an older run with the same seed), gnp (each pair is an edge with the edge chance, in O(N + E)), regular (every node has degree ~ edgeChance * (N-1)), geometric (nodes in the unit square joined within a radius), or powerlaw (Chung-Lu with power-law degrees). All families share the same expected average degree for a given edge chance; use gnp for large graphs.");
+std::shared_ptr <ParameterLink<double>> GraphColorWorld::powerLawExponentPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-powerLawExponent",  2.5, "Exponent of the degree distribution when graphGenerator is powerlaw (Will error if <= 1)");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::graphFilePL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphFile",  (std::string)"", "If set, evaluate every generation on this graph instead of generating random ones (overrides minGraphNodes/maxGraphNodes). Accepts binary graphs (memory-mapped), DIMACS .col, METIS .graph/.metis, Matrix Market .mtx, or the Graphs/*.txt edge list format.");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::graphPoolSizePL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphPoolSize",  0, "If > 0, this many random graphs are generated at startup (with graphGenerator and the node/edge chance ranges) and every generation is evaluated on one of them, instead of a new graph per generation. Pool graphs are logged once, at startup, with their pool index as the generation.");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::graphPoolFilesPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphPoolFiles",  (std::string)"", "Comma-separated graph files (any format graphFile accepts) added to the graph pool. Address sizes are set by the largest pool graph if it is bigger than maxGraphNodes.");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::graphPoolOrderPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphPoolOrder",  (std::string)"random", "How generations move through the graph pool: random (a random pool graph each time), cycle (in the order they were added), or curriculum (cycle from easiest to hardest, by the colors DSatur needs)");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::graphPoolGenerationsPerGraphPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphPoolGenerationsPerGraph",  1, "Number of consecutive generations evaluated on each pool graph");
+std::shared_ptr <ParameterLink<double>> GraphColorWorld::dynamicGraphEdgeChurnPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-dynamicGraphEdgeChurn",  0.0, "Dynamic graphs: if > 0, every generation after the first is evaluated on the previous generation's graph with this fraction of its edges moved to random new node pairs, instead of on a new graph. Works with a random first graph or graphFile; only the changes are logged (to graph_diff.csv).");
+std::shared_ptr <ParameterLink<double>> GraphColorWorld::dynamicGraphNodeChurnPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-dynamicGraphNodeChurn",  0.0, "Dynamic graphs: if > 0, every generation after the first replaces this fraction of the previous graph's nodes (each loses its edges and is connected to as many random nodes). Combines with dynamicGraphEdgeChurn.");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::graphPrefetchPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-graphPrefetch",  0, "If > 0, each generation's graph (random, or churned for dynamic graphs) is built on a background thread while the generations before it are evaluated, up to this many generations ahead (1 = double buffering). Pipelined graphs draw their parameters and seeds from a generator seeded once from MABE's, so they differ from the graphs an unpipelined run draws, but a run is still reproducible from its seed. Needs a non-legacy graphGenerator (or graphFile with dynamic graphs); cannot be combined with a graph pool. 0 = off");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::normalizeGraphScorePL = Parameters::register_parameter("WORLD_GRAPH_COLOR-normalizeGraphScore",  0, "If 1, a valid coloring's graphScore is scaled by (colors the best known coloring uses) / (colors used), so only colorings as good as greedy/DSatur get full marks. Known colorings are cached for pool and loaded graphs; random graphs are analyzed every generation. (1 for yes, 0 for no)");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::exactColoringBudgetPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-exactColoringBudget",  100000, "Partial colorings the exact branch-and-bound solver may explore per pool (or normalized) graph when looking for its chromatic number; 0 = use only greedy and DSatur");
+
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::evaluationThreadsPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-evaluationThreads",  1, "Number of threads used to evaluate the population (1 = serial, 0 = one per hardware thread). Results are identical for any thread count, but brains must not use MABE's shared random generator when > 1. Every evaluation now draws its own seed from MABE's generator, so even serial results differ from those of older versions with the same seed.");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::evaluationProcessesPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-evaluationProcesses",  1, "Number of processes used to evaluate the population (1 = this process only, 0 = one per hardware thread). Workers are forked each generation and share the brains and graph copy-on-write, so brains need not be thread-safe. Cannot be combined with evaluationThreads > 1 or graphPrefetch; the graph log's writer thread is stopped while the workers are forked. Workers send their message and perf statistics back to this process.");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::nodeThreadsPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-nodeThreads",  1, "Number of threads that share the brain updates and output decoding of each evaluation, for very large graphs (1 = serial, 0 = one per hardware thread). Actions are still applied in the shuffled node order, so results are identical for any thread count for deterministic brains. Brains must be thread-safe and must not draw from MABE's shared random generator (as Markov brains with probabilistic gates do): those race on it, so their results are neither reproducible nor safe. Cannot be combined with evaluationThreads or evaluationProcesses > 1.");
+std::shared_ptr <ParameterLink<std::string>> GraphColorWorld::evaluationRandomPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-evaluationRandom",  (std::string)"mt19937", "Where each evaluation's initial colors and node orders come from: mt19937 (a generator seeded from MABE's for each evaluation, as in earlier versions) or philox (a counter-based generator keyed by generation, organism, eval and tick, filled in bulk and needing no per-evaluation draws from MABE)");
+std::shared_ptr <ParameterLink<int>> GraphColorWorld::racingEliteCountPL = Parameters::register_parameter("WORLD_GRAPH_COLOR-racingEliteCount",  0, "If > 0, the first this many organisms of each generation are evaluated in full, and every later evaluation stops as soon as even a perfect rest of its lifetime could not reach the this-many-th best of their evaluation scores (so it could not be among the generation's top this many evaluations). Stopped evaluations keep the score they had and are recorded in Truncated. 0 = off");
 
 GraphColorWorld::GraphColorWorld(std::shared_ptr <ParametersTable> PT_) : AbstractWorld(PT_) {
     // columns to be added to ave file (configure data collection)
@@ -49,11 +71,24 @@ GraphColorWorld::GraphColorWorld(std::shared_ptr <ParametersTable> PT_) : Abstra
     popFileColumns.push_back("score_VAR"); // specifies to also record the
     // variance (performed automatically
     // because _VAR)
-    popFileColumns.push_back("graphScore");
-    popFileColumns.push_back("Send_msg");
-    popFileColumns.push_back("Change_Color");
-    popFileColumns.push_back("Read_msg");
-    popFileColumns.push_back("Computation_rounds");
+    std::string metricsOutput = metricsOutputPL->get(PT);
+    if(metricsOutput != "dataMap" && metricsOutput != "binary" && metricsOutput != "both"){
+        std::cout << "Unknown metricsOutput \"" << metricsOutput << "\" (expected dataMap, binary or both)" << std::endl;
+        exit(-1);
+    }
+    metricsToDataMap = metricsOutput != "binary";
+    racingEliteCount = std::max(0, racingEliteCountPL->get(PT));
+    if(metricsToDataMap){
+        popFileColumns.push_back("graphScore");
+        popFileColumns.push_back("Send_msg");
+        popFileColumns.push_back("Change_Color");
+        popFileColumns.push_back("Read_msg");
+        popFileColumns.push_back("Computation_rounds");
+        popFileColumns.push_back("Dropped_msg");
+        popFileColumns.push_back("Queue_high_water");
+        if(racingEliteCount > 0)
+            popFileColumns.push_back("Truncated");
+    }
 
     // Set up graph file
     
@@ -74,17 +109,91 @@ GraphColorWorld::GraphColorWorld(std::shared_ptr <ParametersTable> PT_) : Abstra
     useSetColorBit = useSetColorBitPL->get(PT) > 0;
     useSetColorVetoBit = (useSetColorBit && useSetColorVetoBitPL > 0);
 
+    deltaInputs = deltaInputsPL->get(PT) > 0;
+
    
+    if(messageQueueCapacityPL->get(PT) < 0){
+        std::cout << "messageQueueCapacity must be >= 0, was passed " << messageQueueCapacityPL->get(PT) << std::endl;
+        exit(-1);
+    }
+    messageQueueCapacity = messageQueueCapacityPL->get(PT);
+    if(messageOverflowPolicyPL->get(PT) == "dropNewest")
+        messageOverflowPolicy = MessageQueues::DROP_NEWEST;
+    else if(messageOverflowPolicyPL->get(PT) == "dropOldest")
+        messageOverflowPolicy = MessageQueues::DROP_OLDEST;
+    else{
+        std::cout << "messageOverflowPolicy must be dropNewest or dropOldest, was passed " 
+                  << messageOverflowPolicyPL->get(PT) << std::endl;
+        exit(-1);
+    }
+
     minGraphNodes = minGraphNodesPL->get(PT);
     maxGraphNodes = maxGraphNodesPL->get(PT);
     minEdgeChance = minEdgeChancePL->get(PT);
     maxEdgeChance = maxEdgeChancePL->get(PT);
+    graphGenerator = GraphGenerators::type_from_string(graphGeneratorPL->get(PT));
+    powerLawExponent = powerLawExponentPL->get(PT);
+    graphFile = graphFilePL->get(PT);
+    graphOutputDir = graphOutputDirPL->get(PT);
+    graphLog.format = GraphLog::format_from_string(graphLogFormatPL->get(PT));
+    normalizeGraphScore = normalizeGraphScorePL->get(PT) > 0;
+    dynamicGraphEdgeChurn = dynamicGraphEdgeChurnPL->get(PT);
+    dynamicGraphNodeChurn = dynamicGraphNodeChurnPL->get(PT);
+    if(!graphFile.empty()){
+        G.load_from_file(graphFile);
+        std::cout << "Evaluating on " << graphFile << " (" << G.node_count << " nodes, " 
+                  << G.edge_count << " edges)" << std::endl;
+        // Size addresses (and the default color count) for the loaded graph
+        minGraphNodes = maxGraphNodes = std::max((size_t)1, G.node_count);
+    }
     verifyGraphGenVars();    
     
-    graphOutputDir = graphOutputDirPL->get(PT);
-    graph_file.open(graphOutputDir + "/graph.csv", std::ios::out);
-    std::cout << "Saving each graph to " << graphOutputDir << "/graph.csv" << std::endl;
-    graph_file << "node_count,edge_count,adj_vec" << std::endl;
+    graphLog.open(graphOutputDir, graphLog.format, (size_t)std::max(0, graphLogBufferMBPL->get(PT)) << 20);
+    if(graphLog.format != GraphLog::NONE)
+        std::cout << "Saving each graph to " << graphLog.path << std::endl;
+    if(metricsOutput != "dataMap"){
+        openMetricsLog(graphOutputDir + "/metrics.gcm");
+        std::cout << "Saving per-evaluation metrics to " << metricsLog.path << std::endl;
+    }
+    if(!graphFile.empty()){
+        GraphLog::Entry entry;
+        entry.topology = G.topology;
+        entry.generator = "file:" + graphFile;
+        entry.num_nodes = G.node_count;
+        graphLog.log(entry);
+        if(normalizeGraphScore)
+            bestKnownColors = GraphPool::describe(G.topology, entry.generator, 
+                                                  exactColoringBudgetPL->get(PT)).best_colors();
+    }
+
+    // Build the graph pool, if any, paying for generation and analysis once
+    graphPool.order = GraphPool::order_from_string(graphPoolOrderPL->get(PT));
+    graphPool.exact_search_nodes = exactColoringBudgetPL->get(PT);
+    graphPool.generations_per_graph = graphPoolGenerationsPerGraphPL->get(PT);
+    for(int i = 0; i < graphPoolSizePL->get(PT); ++i){
+        GraphLog::Entry entry = makeRandomGraph(i);
+        graphLog.log(entry);
+        graphPool.add(entry.topology, entry.generator);
+    }
+    std::stringstream poolFiles(graphPoolFilesPL->get(PT));
+    std::string poolFile;
+    while(std::getline(poolFiles, poolFile, ',')){
+        if(poolFile.empty())
+            continue;
+        GraphLog::Entry entry;
+        entry.topology = GraphIO::load(poolFile, G.bitset_policy);
+        entry.generator = "file:" + poolFile;
+        entry.num_nodes = entry.topology->node_count;
+        entry.generation = graphPool.entries.size();
+        graphLog.log(entry);
+        graphPool.add(entry.topology, entry.generator);
+    }
+    if(!graphPool.empty()){
+        graphPool.finalize();
+        graphPool.print_summary(std::cout);
+        // Size addresses (and the default color count) for the largest pool graph
+        maxGraphNodes = std::max((size_t)maxGraphNodes, graphPool.max_node_count());
+    }
  
     addressSize = ceil(log2(maxGraphNodes));
     
@@ -96,6 +205,10 @@ GraphColorWorld::GraphColorWorld(std::shared_ptr <ParametersTable> PT_) : Abstra
     G.reset_colors(colorSize);
     std::cout << "Maximum colors: " << maxColors << std::endl;
     
+    // Sender and color inputs are packed into one word per node
+    if(addressSize + colorSize > 64)
+        deltaInputs = false;
+
     // Set the bit positions based on what all we have configured
     newMsgBitPos = addressSize + colorSize;
     size_t curPos = addressSize + colorSize;
@@ -111,211 +224,600 @@ GraphColorWorld::GraphColorWorld(std::shared_ptr <ParametersTable> PT_) : Abstra
         setColorBitPos = curPos++;
     if(useSetColorVetoBit)
         setColorVetoBitPos = curPos++;
+    evaluationFn = selectEvaluation();
+
+    evaluationThreads = evaluationThreadsPL->get(PT);
+    if(evaluationThreads == 0)
+        evaluationThreads = std::max(1u, std::thread::hardware_concurrency());
+    if(evaluationThreads < 0){
+        std::cout << "evaluationThreads must be >= 0, was passed " << evaluationThreads << std::endl;
+        exit(-1);
+    }
+    if(evaluationThreads > 1){
+        pool = std::make_shared<WorkStealingPool>(evaluationThreads);
+        std::cout << "Evaluating with " << evaluationThreads << " threads" << std::endl;
+    }
+    evaluationProcesses = evaluationProcessesPL->get(PT);
+    if(evaluationProcesses == 0)
+        evaluationProcesses = std::max(1u, std::thread::hardware_concurrency());
+    if(evaluationProcesses < 0){
+        std::cout << "evaluationProcesses must be >= 0, was passed " << evaluationProcesses << std::endl;
+        exit(-1);
+    }
+    if(evaluationProcesses > 1 && evaluationThreads > 1){
+        std::cout << "evaluationProcesses and evaluationThreads cannot both be > 1" << std::endl;
+        exit(-1);
+    }
+    if(evaluationProcesses > 1){
+        processPool = std::make_shared<ProcessPool<EvalResult, WorkerReport>>(evaluationProcesses);
+        // The writer must not be running (and maybe holding a lock) when the workers are forked
+        processPool->before_fork = [this]{ graphLog.pause(); };
+        processPool->after_fork = [this]{ graphLog.resume(); };
+        std::cout << "Evaluating with " << evaluationProcesses << " processes" << std::endl;
+    }
+    nodeThreads = nodeThreadsPL->get(PT);
+    if(nodeThreads == 0)
+        nodeThreads = std::max(1u, std::thread::hardware_concurrency());
+    if(nodeThreads < 0){
+        std::cout << "nodeThreads must be >= 0, was passed " << nodeThreads << std::endl;
+        exit(-1);
+    }
+    if(nodeThreads > 1 && (evaluationThreads > 1 || evaluationProcesses > 1)){
+        std::cout << "nodeThreads cannot be > 1 when evaluationThreads or evaluationProcesses is" << std::endl;
+        exit(-1);
+    }
+    if(nodeThreads > 1){
+        nodePool = std::make_shared<WorkStealingPool>(nodeThreads);
+        std::cout << "Updating each evaluation's nodes with " << nodeThreads << " threads" << std::endl;
+    }
+    contexts.resize(evaluationThreads);
 
+    std::string evaluationRandom = evaluationRandomPL->get(PT);
+    if(evaluationRandom != "mt19937" && evaluationRandom != "philox"){
+        std::cout << "Unknown evaluationRandom \"" << evaluationRandom << "\" (expected mt19937 or philox)" << std::endl;
+        exit(-1);
+    }
+    counterRandom = evaluationRandom == "philox";
+    counterRandomKey = counterRandom ? (uint32_t)Random::getInt(0, std::numeric_limits<int>::max()) : 0;
+
+    int graphPrefetch = graphPrefetchPL->get(PT);
+    if(graphPrefetch > 0){
+        // Pausing the builder around every fork would put the graph it is building on the critical path
+        if(processPool != nullptr){
+            std::cout << "graphPrefetch cannot be combined with evaluationProcesses > 1 (its thread would be "
+                      << "running when the workers are forked)" << std::endl;
+            exit(-1);
+        }
+        if(!graphPool.empty()){
+            std::cout << "graphPrefetch cannot be combined with a graph pool (graphPoolSize or graphPoolFiles)" << std::endl;
+            exit(-1);
+        }
+        if(graphFile.empty() && graphGenerator == GraphGenerators::LEGACY){
+            std::cout << "graphPrefetch cannot build legacy graphs (they draw from MABE's generator); use another "
+                      << "graphGenerator" << std::endl;
+            exit(-1);
+        }
+        if(!graphFile.empty() && !dynamicGraphs()){
+            std::cout << "graphPrefetch has nothing to build: graphFile is used for every generation" << std::endl;
+            exit(-1);
+        }
+        graphPipelineKey = (uint64_t)Random::getInt(0, std::numeric_limits<int>::max());
+        // A loaded graph is generation 0's, and the first one churned
+        pipelineTopology = graphFile.empty() ? nullptr : G.topology;
+        graphPipeline.start(graphPrefetch, graphFile.empty() ? 0 : 1, [this](size_t logGeneration){
+            return produceGraph(logGeneration);
+        });
+        std::cout << "Building graphs up to " << graphPrefetch << " generations ahead in the background" << std::endl;
+    }
+
+#ifdef GRAPH_COLOR_ENABLE_PERF
+    perfFile.open(graphOutputDir + "/perf.csv");
+    PerfCounters::write_header(perfFile);
+    std::cout << "Saving per-phase timings to " << graphOutputDir << "/perf.csv" << std::endl;
+#endif
 }
 
-void GraphColorWorld::evaluateSolo(std::shared_ptr <Organism> org, int analyze, int visualize, int debug) {
+void GraphColorWorld::evaluateSolo(std::shared_ptr <Organism> org, size_t orgIndex, int analyze, int visualize, int debug) {
     //store the org's brain
     auto originalBrain = org->brains[brainNamePL->get(PT)];
 
+    EvalResult result;
+    for (size_t eval = 0; eval < evaluationsPerGeneration; eval++) {
+        runEvaluation(originalBrain, nextEvaluationSeed(), orgIndex, eval, contexts[0], result, visualize);
+        recordResult(org, eval, result, visualize);
+        if (orgIndex < racingEliteCount)
+            racingScores.push_back(result.score);
+    } // evals per generation
+}
+
+void GraphColorWorld::setRacingThreshold() {
+    if (racingEliteCount == 0 || racingScores.size() < racingEliteCount)
+        return;
+    std::nth_element(racingScores.begin(), racingScores.begin() + (racingEliteCount - 1), racingScores.end(), 
+                     std::greater<double>());
+    racingThreshold = racingScores[racingEliteCount - 1];
+}
+
+void GraphColorWorld::evaluateParallel(std::vector<std::shared_ptr<Organism>>& population) {
+    // Look up brains on this thread
+    std::vector<std::shared_ptr<AbstractBrain>> brains(population.size());
+    for (size_t i = 0; i < population.size(); i++) {
+        brains[i] = population[i]->brains[brainNamePL->get(PT)];
+    }
+    std::vector<EvalResult> results;
+    evaluateBrains(brains, results);
+
+    for (size_t task = 0; task < results.size(); task++) {
+        recordResult(population[task / evaluationsPerGeneration], task % evaluationsPerGeneration, results[task], 0);
+    }
+}
+
+void GraphColorWorld::evaluateBrains(const std::vector<std::shared_ptr<AbstractBrain>>& brains, 
+                                     std::vector<EvalResult>& results) {
+    // Draw seeds on this thread, in the same order evaluateSolo would
+    size_t numTasks = brains.size() * evaluationsPerGeneration;
+    std::vector<uint32_t> seeds(numTasks);
+    results.assign(numTasks, EvalResult());
+    for (size_t task = 0; task < numTasks; task++) {
+        seeds[task] = nextEvaluationSeed();
+    }
+
+    // One task per (organism, eval); costs vary a lot because of early termination
+    auto runTasks = [&](size_t begin, size_t end){
+        if(processPool != nullptr){
+            // Each process has its own copy of contexts[0]. Its statistics are banked first, so
+            // the forked copies start from zero and report only their own evaluations.
+            EvalContext& ctx = contexts[0];
+            forkedStats.messages.merge(ctx.msgQueues.total_stats);
+            forkedStats.messages.merge(ctx.msgQueues.stats);
+            ctx.msgQueues.total_stats = MessageQueues::Stats();
+            ctx.msgQueues.stats = MessageQueues::Stats();
+            GRAPH_COLOR_PERF(forkedStats.perf.merge(ctx.perf); ctx.perf = PerfCounters());
+            std::vector<EvalResult> batchResults;
+            std::vector<WorkerReport> reports;
+            processPool->run(end - begin, batchResults, [&](size_t i, EvalResult& result){
+                size_t task = begin + i;
+                runEvaluation(brains[task / evaluationsPerGeneration], seeds[task], task / evaluationsPerGeneration,
+                              task % evaluationsPerGeneration, ctx, result, 0);
+            }, reports, [&](WorkerReport& report){
+                report.messages = ctx.msgQueues.total_stats;
+                report.messages.merge(ctx.msgQueues.stats);
+                GRAPH_COLOR_PERF(report.perf = ctx.perf);
+            });
+            for(auto& report : reports){
+                forkedStats.messages.merge(report.messages);
+                GRAPH_COLOR_PERF(forkedStats.perf.merge(report.perf));
+            }
+            std::copy(batchResults.begin(), batchResults.end(), results.begin() + begin);
+        }
+        else{
+            pool->run(end - begin, [&](size_t i, size_t worker){
+                size_t task = begin + i;
+                runEvaluation(brains[task / evaluationsPerGeneration], seeds[task], task / evaluationsPerGeneration,
+                              task % evaluationsPerGeneration, contexts[worker], results[task], 0);
+            });
+        }
+    };
+    // With racing, the pace setters run in full first, so every thread races against the same threshold
+    size_t paceSetters = std::min(numTasks, racingEliteCount * evaluationsPerGeneration);
+    runTasks(0, paceSetters);
+    for (size_t task = 0; task < paceSetters; task++) {
+        racingScores.push_back(results[task].score);
+    }
+    setRacingThreshold();
+    runTasks(paceSetters, numTasks);
+}
+
+void GraphColorWorld::openMetricsLog(const std::string& path) {
+    metricsLog.open(path);
+    metricsColumns.generation = metricsLog.add_column("generation", Metrics::INT64);
+    metricsColumns.organism = metricsLog.add_column("organism", Metrics::INT64);
+    metricsColumns.eval = metricsLog.add_column("eval", Metrics::INT64);
+    metricsColumns.score = metricsLog.add_column("score", Metrics::DOUBLE);
+    metricsColumns.graphScore = metricsLog.add_column("graphScore", Metrics::DOUBLE);
+    metricsColumns.sends = metricsLog.add_column("Send_msg", Metrics::INT64);
+    metricsColumns.colorChanges = metricsLog.add_column("Change_Color", Metrics::INT64);
+    metricsColumns.reads = metricsLog.add_column("Read_msg", Metrics::INT64);
+    metricsColumns.rounds = metricsLog.add_column("Computation_rounds", Metrics::INT64);
+    metricsColumns.droppedMessages = metricsLog.add_column("Dropped_msg", Metrics::INT64);
+    metricsColumns.queueHighWater = metricsLog.add_column("Queue_high_water", Metrics::INT64);
+    if (racingEliteCount > 0)
+        metricsColumns.truncated = metricsLog.add_column("Truncated", Metrics::INT64);
+}
+
+void GraphColorWorld::recordResult(std::shared_ptr <Organism> org, size_t eval, const EvalResult& result, int visualize) {
+    if (metricsLog.is_open()) {
+        //generation was already advanced for this generation's evaluations
+        metricsLog.set(metricsColumns.generation, (int64_t)generation - 1);
+        metricsLog.set(metricsColumns.organism, (int64_t)org->ID);
+        metricsLog.set(metricsColumns.eval, (int64_t)eval);
+        metricsLog.set(metricsColumns.score, result.score);
+        metricsLog.set(metricsColumns.graphScore, result.graphScore);
+        metricsLog.set(metricsColumns.sends, (int64_t)result.sends);
+        metricsLog.set(metricsColumns.colorChanges, (int64_t)result.colorChanges);
+        metricsLog.set(metricsColumns.reads, (int64_t)result.reads);
+        metricsLog.set(metricsColumns.rounds, (int64_t)result.rounds);
+        metricsLog.set(metricsColumns.droppedMessages, (int64_t)result.droppedMessages);
+        metricsLog.set(metricsColumns.queueHighWater, (int64_t)result.queueHighWater);
+        if (racingEliteCount > 0)
+            metricsLog.set(metricsColumns.truncated, (int64_t)result.truncated);
+        metricsLog.end_row();
+    }
+
+    //end of life cleanup
+    org->dataMap.append("score", result.score);
+
+    if (metricsToDataMap) {
+        org->dataMap.append("graphScore", result.graphScore);
+        org->dataMap.append("Send_msg", result.sends);
+        org->dataMap.append("Change_Color", result.colorChanges);
+        org->dataMap.append("Read_msg", result.reads);
+        org->dataMap.append("Computation_rounds", result.rounds);
+        org->dataMap.append("Dropped_msg", result.droppedMessages);
+        org->dataMap.append("Queue_high_water", result.queueHighWater);
+        if (racingEliteCount > 0)
+            org->dataMap.append("Truncated", (int)result.truncated);
+    }
+
+    //TODO: Actually tie score in
+    if (visualize)
+        std::cout << "organism with ID " << org->ID << " scored " << result.score << std::endl;
+}
+
+template<int Features>
+GraphColorWorld::EvaluationFn GraphColorWorld::selectEvaluationSetColor() {
+    if (!useSetColorBit)
+        return &GraphColorWorld::runEvaluationFor<Features>;
+    if (!useSetColorVetoBit)
+        return &GraphColorWorld::runEvaluationFor<Features | SET_COLOR_BIT>;
+    return &GraphColorWorld::runEvaluationFor<Features | SET_COLOR_BIT | SET_COLOR_VETO_BIT>;
+}
+
+template<int Features>
+GraphColorWorld::EvaluationFn GraphColorWorld::selectEvaluationGet() {
+    if (!useGetMsgBit)
+        return selectEvaluationSetColor<Features>();
+    if (!useGetMsgVetoBit)
+        return selectEvaluationSetColor<Features | GET_MSG_BIT>();
+    return selectEvaluationSetColor<Features | GET_MSG_BIT | GET_MSG_VETO_BIT>();
+}
+
+template<int Features>
+GraphColorWorld::EvaluationFn GraphColorWorld::selectEvaluationSend() {
+    if (!useSendMsgBit)
+        return selectEvaluationGet<Features>();
+    if (!useSendMsgVetoBit)
+        return selectEvaluationGet<Features | SEND_MSG_BIT>();
+    return selectEvaluationGet<Features | SEND_MSG_BIT | SEND_MSG_VETO_BIT>();
+}
+
+GraphColorWorld::EvaluationFn GraphColorWorld::selectEvaluation() {
+    return useNewMsgBit ? selectEvaluationSend<NEW_MSG_BIT>() : selectEvaluationSend<0>();
+}
+
+template<int Features>
+void GraphColorWorld::runEvaluationFor(std::shared_ptr<AbstractBrain> originalBrain, uint32_t seed, size_t orgIndex, 
+                                       size_t eval, EvalContext& ctx, EvalResult& result, int visualize) {
+    //the configured I/O bits, and where the control bits sit after the address and color bits
+    constexpr bool newMsgBit = Features & NEW_MSG_BIT;
+    constexpr bool sendMsgBit = Features & SEND_MSG_BIT;
+    constexpr bool sendMsgVetoBit = Features & SEND_MSG_VETO_BIT;
+    constexpr bool getMsgBit = Features & GET_MSG_BIT;
+    constexpr bool getMsgVetoBit = Features & GET_MSG_VETO_BIT;
+    constexpr bool setColorBit = Features & SET_COLOR_BIT;
+    constexpr bool setColorVetoBit = Features & SET_COLOR_VETO_BIT;
+    constexpr size_t sendMsgVetoOffset = sendMsgBit;
+    constexpr size_t getMsgOffset = sendMsgVetoOffset + sendMsgVetoBit;
+    constexpr size_t getMsgVetoOffset = getMsgOffset + getMsgBit;
+    constexpr size_t setColorOffset = getMsgVetoOffset + getMsgVetoBit;
+    constexpr size_t setColorVetoOffset = setColorOffset + setColorBit;
+    const size_t controlPos = addressSize + colorSize;
+
+    //all randomness in this evaluation comes from its own seed, or its own counter-based stream
+    std::mt19937 rng(seed);
+    auto taskRandInt = [&rng](int i){ return std::uniform_int_distribution<int>(0, i-1)(rng); };
+    CounterRandom::Stream stream(counterRandomKey, (uint32_t)generation, (uint32_t)orgIndex, (uint32_t)eval);
+    std::vector<uint32_t>& randomWords = ctx.randomWords;
+
+    //colors live in the context, the topology is shared with the world's graph
+    Graph& G = ctx.G;
+    if (G.topology != this->G.topology)
+        G.set_topology(this->G.topology);
+
     //store some useful data about the original brain
     auto numBrainInputs = originalBrain->nrInputValues;
     auto numBrainOutputs = originalBrain->nrOutputValues;
 
-    //clone the brain, one for each node
+    //clone the brain, one for each node (an organism's later evaluations in this context reuse the clones)
     //ALSO create a list of ints: used to visit each node exactly once in a random order each APL
-    std::vector<std::shared_ptr<AbstractBrain>> cloneBrains(G.node_count);
-    std::vector<size_t> nodeOrder(G.node_count); //TODO just shuffle the brain vector??
-    std::vector<std::queue<NodeMessage>> msgQueues(G.node_count);
-    std::vector<uint8_t> deliverMsgVec(G.node_count);
+    std::vector<std::shared_ptr<AbstractBrain>>& cloneBrains = ctx.cloneBrains;
+    if (ctx.clonedBrain.lock() != originalBrain || cloneBrains.size() != G.node_count) {
+        ctx.clonedBrain = originalBrain;
+        cloneBrains.resize(G.node_count);
+        for (size_t i = 0; i < G.node_count; i++) {
+            cloneBrains[i] = originalBrain->makeCopy(originalBrain->PT);
+        }
+    }
+
+    auto setInput = [&](size_t node, size_t i, double value){
+        cloneBrains[node]->setInput(i, value);
+    };
+    auto readOutput = [&](size_t node, size_t o){
+        return cloneBrains[node]->readOutput(o);
+    };
+    //the inboxes, node order and delivery flags are kept in the context, so nothing is reallocated
+    std::vector<size_t>& nodeOrder = ctx.nodeOrder; //TODO just shuffle the brain vector??
+    MessageQueues& msgQueues = ctx.msgQueues;
+    std::vector<uint8_t>& deliverMsgVec = ctx.deliverMsgVec;
+    msgQueues.reset(G.node_count, messageQueueCapacity, messageOverflowPolicy);
+    nodeOrder.resize(G.node_count);
+    deliverMsgVec.assign(G.node_count, 0);
 
     for (size_t i = 0; i < G.node_count; i++) {
-        cloneBrains[i] = originalBrain->makeCopy(originalBrain->PT);
         nodeOrder[i] = i;
     }
+    std::vector<NodeAction>& actions = ctx.actions;
+    //inputs the brains hold, so deliveries only write what changes
+    PackedInputs& messageInputs = ctx.messageInputs;
+    PackedInputs& newMsgInputs = ctx.newMsgInputs;
+    if (deltaInputs) {
+        messageInputs.reset(G.node_count, controlPos);
+        newMsgInputs.reset(G.node_count, 1);
+    }
+    const uint64_t addressMask = addressSize == 0 ? 0 : ~(uint64_t)0 >> (64 - addressSize);
+    if (nodePool)
+        actions.resize(G.node_count);
+
+    //decodes what a node's outputs ask for
+    //-------------------------------------------------------------
+    //| Target Address | Color | S? | SV? | G? | GV? | C? | CV? |
+    //-------------------------------------------------------------
+    auto decodeAction = [&](size_t brainID){
+        NodeAction action;
+        action.set_color = (!setColorBit || Bit(readOutput(brainID, controlPos + setColorOffset)) == 1) &&
+                           (!setColorVetoBit || Bit(readOutput(brainID, controlPos + setColorVetoOffset)) != 1);
+        if (action.set_color) {
+            for(size_t i = 0; i < colorSize; i++){ // All bits at once, so the conflict counts update once
+                action.color_bits = (action.color_bits << 1) | (uint32_t)Bit(readOutput(brainID, i + addressSize));
+            }
+        }
+        //TODO: Do we need a threshold on outputs, or do we treat them as binary?
+        action.send = (!sendMsgBit || Bit(readOutput(brainID, controlPos)) == 1) &&
+                      (!sendMsgVetoBit || Bit(readOutput(brainID, controlPos + sendMsgVetoOffset)) != 1);
+        if (action.send) {
+            // Convert output the address to send to
+            size_t bit = 1;
+            for(size_t i = 0; i < addressSize; ++i){
+                if(Bit(readOutput(brainID, i)) == 1){
+                    action.target |= bit;
+                }
+                bit <<= 1;
+            }
+        }
+        // Did the brain request a message from its queue (for its next input?)
+        action.get = (!getMsgBit || Bit(readOutput(brainID, controlPos + getMsgOffset)) == 1) &&
+                     (!getMsgVetoBit || Bit(readOutput(brainID, controlPos + getMsgVetoOffset)) != 1);
+        return action;
+    };
 
+    //pre-lifetime setup
     double score = 0.0;
-    int sends, color_changes, reads;
+    int sends = 0;
+    int color_changes = 0;
+    int reads = 0;
+    if (counterRandom) {
+        //position 0 is the initial coloring, position t + 1 is tick t's shuffle
+        randomWords.resize(G.node_count);
+        stream.fill(0, randomWords.data(), G.node_count);
+        G.reset_colors(colorSize, randomWords.data());
+    }
+    else {
+        G.reset_colors(colorSize, rng);
+    }
 
-    for (size_t eval = 0; eval < evaluationsPerGeneration; eval++) {
-        //pre-lifetime setup
-        score = 0.0;
-        sends = 0;
-        color_changes = 0;
-        reads = 0;
-        G.reset_colors(colorSize);
-    
-        for (auto brain:cloneBrains) {
-            brain->resetBrain();
-        }
+    for (auto brain:cloneBrains) {
+        brain->resetBrain();
+    }
+
+    //lifetime loop (action-perception loop)
+    size_t t;
+    size_t solve_count = 0; //used to detect early termination
+    bool truncated = false;
+    const size_t solveThreshold = 20; // TODO: 20 is chosen arbetrarily, make this a parameter
+    for (t = 0; t < agentLifetime; t++) {
+        GRAPH_COLOR_PERF(ctx.perf.begin());
+        
+        // give agents their inputs
+
+        //---------------------------------------------------
+        //| message sender addr | message sender color | M? |
+        //---------------------------------------------------
+
+        for (auto brainID:nodeOrder) {
+
+            bool hasMsg = !msgQueues.empty(brainID); //check before message read
 
-        //lifetime loop (action-perception loop)
-        size_t t;
-        size_t solve_count = 0; //used to detect early termination
-        for (t = 0; t < agentLifetime; t++) {
-            
-            // give agents their inputs
-
-            //---------------------------------------------------
-            //| message sender addr | message sender color | M? |
-            //---------------------------------------------------
-
-            for (auto brainID:nodeOrder) {
-
-                bool hasMsg = msgQueues[brainID].size() > 0; //check before message read
-
-                if (deliverMsgVec[brainID]){
-                    if (hasMsg){
-                        //set message sender addr and message sender color
-                        NodeMessage msg = msgQueues[brainID].front();
-                        msgQueues[brainID].pop();
-                        for(size_t i = 0; i < addressSize; ++i){ // Set sender's address
-                            cloneBrains[brainID]->setInput(i, msg.senderAddr[i]);
-                        }
-                        for(size_t i = 0; i < colorSize; ++i){ // Set msg. contents (color)
-                            cloneBrains[brainID]->setInput(i + addressSize, msg.contents[i]);
-                        }
+            if (deliverMsgVec[brainID] && deltaInputs){
+                //the sender and color as the input bits below would set them
+                uint64_t word = 0;
+                if (hasMsg){
+                    NodeMessage msg = msgQueues.pop(brainID);
+                    word = (msg.sender & 1) ? addressMask : 0;
+                    for(size_t i = 0; i < colorSize; ++i){
+                        word |= (uint64_t)((msg.color_bits >> (colorSize - 1 - i)) & 1) << (i + addressSize);
                     }
-                    else{
-                        //set sender and color to all 0s
-                        for (int i = 0; i < addressSize + colorSize; i++) {
-                            cloneBrains[brainID]->setInput(i, 0);
-                        }
+                }
+                messageInputs.write(brainID, word, [&](size_t i, double value){ setInput(brainID, i, value); });
+            }
+            else if (deliverMsgVec[brainID]){
+                if (hasMsg){
+                    //set message sender addr and message sender color
+                    NodeMessage msg = msgQueues.pop(brainID);
+                    // Every address bit carries the sender's lowest bit, as the original
+                    // message encoding did (its bit mask was never shifted)
+                    double senderBit = (double)(msg.sender & 1);
+                    for(size_t i = 0; i < addressSize; ++i){ // Set sender's address
+                        setInput(brainID, i, senderBit);
+                    }
+                    for(size_t i = 0; i < colorSize; ++i){ // Set msg. contents (color), most significant bit first
+                        setInput(brainID, i + addressSize, (double)((msg.color_bits >> (colorSize - 1 - i)) & 1));
                     }
                 }
-
-                if(useNewMsgBit){ //Set "You've got mail!" bit if we have more messages
-                    cloneBrains[brainID]->setInput(newMsgBitPos, (double)(msgQueues[brainID].size() > 0));
+                else{
+                    //set sender and color to all 0s
+                    for (int i = 0; i < addressSize + colorSize; i++) {
+                        setInput(brainID, i, 0);
+                    }
                 }
-
-
-                // bool hasMsg = msgQueues[brainID].size() > 0;
-                // if(!hasMsg){ // No message? Give them all zeroes
-                //     for (int i = 0; i < numBrainInputs; i++) {
-                //         cloneBrains[brainID]->setInput(i, 0);
-                //     }
-                // }
-                // else if(hasMsg && deliverMsgVec[brainID]){ // Deliver the next message
-                //     NodeMessage msg = msgQueues[brainID].front();
-                //     msgQueues[brainID].pop();
-                //     for(size_t i = 0; i < addressSize; ++i){ // Set sender's address
-                //         cloneBrains[brainID]->setInput(i, msg.senderAddr[i]);
-                //     }
-                //     for(size_t i = 0; i < colorSize; ++i){ // Set msg. contents (color)
-                //         cloneBrains[brainID]->setInput(i + addressSize, msg.contents[i]);
-                //     }
-                //     //TODO: Verify this is a "you still have a msg" bit and not a "we delivered" bit
-                //     if(useNewMsgBit){ //Set "You've got mail!" bit if we have more messages
-                //         cloneBrains[brainID]->setInput(newMsgBitPos, 
-                //             (double)(msgQueues[brainID].size() > 0));
-                //     }
-                // }
-                // else{ // Message exists but was not requested
-                //     for (int i = 0; i < numBrainInputs; i++) {
-                //         cloneBrains[brainID]->setInput(i, 0);
-                //     }
-                //     if(useNewMsgBit)
-                //         cloneBrains[brainID]->setInput(newMsgBitPos, 1);
-                // }
             }
 
-            //update each agent (lets agents think for a single time unit)
-            for (auto brain:cloneBrains) {
-                brain->update();
+            if(newMsgBit){ //Set "You've got mail!" bit if we have more messages
+                if (deltaInputs)
+                    newMsgInputs.write(brainID, !msgQueues.empty(brainID), [&](size_t, double value){ 
+                        setInput(brainID, controlPos, value); 
+                    });
+                else
+                    setInput(brainID, controlPos, (double)(!msgQueues.empty(brainID)));
             }
 
-            //update the world according to each agent's chosen action (visit each node in an unbiased random order)
-            std::random_shuffle(nodeOrder.begin(), nodeOrder.end(), randInt);
-
-            //-------------------------------------------------------------
-            //| Target Address | Color | S? | SV? | G? | GV? | C? | CV? |
-            //-------------------------------------------------------------
 
-            for (auto brainID:nodeOrder) {
+            // bool hasMsg = msgQueues[brainID].size() > 0;
+            // if(!hasMsg){ // No message? Give them all zeroes
+            //     for (int i = 0; i < numBrainInputs; i++) {
+            //         cloneBrains[brainID]->setInput(i, 0);
+            //     }
+            // }
+            // else if(hasMsg && deliverMsgVec[brainID]){ // Deliver the next message
+            //     NodeMessage msg = msgQueues[brainID].front();
+            //     msgQueues[brainID].pop();
+            //     for(size_t i = 0; i < addressSize; ++i){ // Set sender's address
+            //         cloneBrains[brainID]->setInput(i, msg.senderAddr[i]);
+            //     }
+            //     for(size_t i = 0; i < colorSize; ++i){ // Set msg. contents (color)
+            //         cloneBrains[brainID]->setInput(i + addressSize, msg.contents[i]);
+            //     }
+            //     //TODO: Verify this is a "you still have a msg" bit and not a "we delivered" bit
+            //     if(useNewMsgBit){ //Set "You've got mail!" bit if we have more messages
+            //         cloneBrains[brainID]->setInput(newMsgBitPos, 
+            //             (double)(msgQueues[brainID].size() > 0));
+            //     }
+            // }
+            // else{ // Message exists but was not requested
+            //     for (int i = 0; i < numBrainInputs; i++) {
+            //         cloneBrains[brainID]->setInput(i, 0);
+            //     }
+            //     if(useNewMsgBit)
+            //         cloneBrains[brainID]->setInput(newMsgBitPos, 1);
+            // }
+        }
+        GRAPH_COLOR_PERF(ctx.perf.lap(PerfCounters::INPUT));
 
-                //Update color of the node
-                if(!useSetColorBit || Bit(cloneBrains[brainID]->readOutput(setColorBitPos)) == 1){
-                    if(!useSetColorVetoBit || Bit(cloneBrains[brainID]->readOutput(setColorVetoBitPos)) != 1){
-                        //change color
-                        for(size_t i = 0; i < colorSize; i++){ // Fill contents
-                            G.set_color_by_index(brainID, i, Bit(cloneBrains[brainID]->readOutput(i + addressSize)));
-                        }
-                        score += 1/((t+1)*(t+1)); //diminishing reward for changing color (helps agents discover this ability)
-                        color_changes++;
-                    }
-                }
+        //update each agent (lets agents think for a single time unit)
+        forNodeBlocks(G.node_count, [&](size_t begin, size_t end){
+            for (size_t brainID = begin; brainID < end; brainID++) {
+                cloneBrains[brainID]->update();
+            }
+        });
+        GRAPH_COLOR_PERF(ctx.perf.lap(PerfCounters::UPDATE));
 
-                //TODO: Do we need a threshold on outputs, or do we treat them as binary?
-                if(!useSendMsgBit || Bit(cloneBrains[brainID]->readOutput(sendMsgBitPos)) == 1){
-                    if(!useSendMsgVetoBit || Bit(cloneBrains[brainID]->readOutput(sendMsgVetoBitPos)) != 1){
-                        // Check if we need to send a message
-                        size_t targetID = 0;
-                        size_t bit = 1;
-                        // Convert output the address to send to
-                        for(size_t i = 0; i < addressSize; ++i){
-                            if(Bit(cloneBrains[brainID]->readOutput(i)) == 1){
-                                targetID |= bit;
-                            }
-                            bit <<= 1;
-                        }
-                        // Recipient must be a valid node and our neighbor
-                        if(targetID < G.node_count && G.check_neighbors(brainID, targetID)){
-                            NodeMessage msg(brainID, addressSize, colorSize);
-                            for(size_t i = 0; i < colorSize; i++){ // Fill contents
-                                // reads last stored color, may not be same as output buffer if "update color" was not executed
-                                msg.contents[i] = G.get_color_at_index(brainID, i);
-                            }
-                            msgQueues[targetID].push(msg); // Send the message!
-                        }
-                        score += 1/((t+1)*(t+1)); //diminishing reward for sending a message (helps agents discover this ability)
-                        sends++;
-                    }
-                }
-                // Did the brain request a message from its queue (for its next input?)
-                deliverMsgVec[brainID] = false;
-                if(!useGetMsgBit || Bit(cloneBrains[brainID]->readOutput(getMsgBitPos)) == 1){
-                    if(!useGetMsgVetoBit || Bit(cloneBrains[brainID]->readOutput(getMsgVetoBitPos)) != 1){
-                        deliverMsgVec[brainID] = true;
-                        score += 1/((t+1)*(t+1)); //diminishing reward for delivering message (helps agents discover this ability)
-                        reads++;
-                    } 
+        //update the world according to each agent's chosen action (visit each node in an unbiased random order)
+        if (counterRandom) {
+            stream.fill(t + 1, randomWords.data(), G.node_count);
+            CounterRandom::shuffle(nodeOrder, randomWords.data());
+        }
+        else {
+            std::random_shuffle(nodeOrder.begin(), nodeOrder.end(), taskRandInt);
+        }
+        GRAPH_COLOR_PERF(ctx.perf.lap(PerfCounters::SHUFFLE));
+
+        //with node threads, every action is decoded up front in parallel; applying them
+        //below stays serial, in nodeOrder, so messages queue up as they would serially
+        if (nodePool) {
+            forNodeBlocks(G.node_count, [&](size_t begin, size_t end){
+                for (size_t brainID = begin; brainID < end; brainID++) {
+                    actions[brainID] = decodeAction(brainID);
                 }
+            });
+        }
+        for (auto brainID:nodeOrder) {
+            NodeAction action = nodePool ? actions[brainID] : decodeAction(brainID);
+
+            //Update color of the node
+            if (action.set_color){
+                G.set_color_bits(brainID, action.color_bits);
+                score += 1/((t+1)*(t+1)); //diminishing reward for changing color (helps agents discover this ability)
+                color_changes++;
             }
-            
-            //TODO: Do we use the message contents or something else?
-
-            if (G.check_graph_coloring()){ //reward for stopping earlier
-                solve_count ++; //count up towards threshold
-                if (solve_count == 20){ // TODO: 20 is chosen arbetrarily, make this a parameter
-                    score += agentLifetime - t;
-                    break;
+
+            if (action.send){
+                // Recipient must be a valid node and our neighbor
+                if(action.target < G.node_count && G.check_neighbors(brainID, action.target)){
+                    // reads last stored color, may not be same as output buffer if "update color" was not executed
+                    msgQueues.push(action.target, {(uint32_t)brainID, G.color_bits[brainID]}); // Send the message!
                 }
+                score += 1/((t+1)*(t+1)); //diminishing reward for sending a message (helps agents discover this ability)
+                sends++;
             }
-            else{
-                solve_count = 0; //reset on failure
+            deliverMsgVec[brainID] = action.get;
+            if (action.get){
+                score += 1/((t+1)*(t+1)); //diminishing reward for delivering message (helps agents discover this ability)
+                reads++;
             }
-        } //agent lifetime
+        }
         
+        GRAPH_COLOR_PERF(ctx.perf.lap(PerfCounters::OUTPUT));
+        
+        //TODO: Do we use the message contents or something else?
+
+        bool colored = G.check_graph_coloring();
+        GRAPH_COLOR_PERF(ctx.perf.lap(PerfCounters::CHECK));
+        GRAPH_COLOR_PERF(ctx.perf.end_tick(msgQueues.stats));
+        if (colored){ //reward for stopping earlier
+            solve_count ++; //count up towards threshold
+            if (solve_count == solveThreshold){
+                score += agentLifetime - t;
+                break;
+            }
+        }
+        else{
+            solve_count = 0; //reset on failure
+        }
 
-        auto xXx = G.get_graph_score();
-        if(visualize)
-            G.print_colors();
-        org->dataMap.append("graphScore", xXx);
-        score += xXx;
-
-        //end of life cleanup
-        org->dataMap.append("score", score);
-
-        org->dataMap.append("Send_msg", sends);
-        org->dataMap.append("Change_Color", color_changes);
-        org->dataMap.append("Read_msg", reads);
-        org->dataMap.append("Computation_rounds", int(t));
+        //racing: stop once the best score the rest of the lifetime could bring is below the threshold
+        if (racingThreshold > -std::numeric_limits<double>::infinity()) {
+            //solving as soon as possible, with a perfect coloring and every action taken every tick
+            size_t solveTick = t + solveThreshold - (colored ? solve_count : 0);
+            double bestBonus = solveTick < agentLifetime ? agentLifetime - solveTick : 0;
+            //the action rewards above are integer 1/((t+1)*(t+1)): 1 on tick 0 and 0 on every later
+            //tick, so the ticks still to come (t+1 onward) can earn nothing from actions
+            double bestActions = 0;
+            double bestGraphScore = G.edge_count * 2 * 100.0 / (1 + G.edge_count * 2);
+            if (score + bestBonus + bestActions + bestGraphScore < racingThreshold) {
+                truncated = true;
+                break;
+            }
+        }
+    } //agent lifetime
+    GRAPH_COLOR_PERF(ctx.perf.end_evaluation(msgQueues.stats));
+    
 
-        //TODO: Actually tie score in
-        if (visualize)
-            std::cout << "organism with ID " << org->ID << " scored " << score << std::endl;
-        
-    } // evals per generation
+    auto xXx = G.get_graph_score();
+    // A valid coloring only gets full marks if it uses no more colors than the best known one
+    if(normalizeGraphScore && bestKnownColors > 0 && G.check_graph_coloring())
+        xXx *= std::min(1.0, (double)bestKnownColors / G.get_num_colors());
+    if(visualize)
+        G.print_colors();
+    result.graphScore = xXx;
+    score += xXx;
+
+    result.score = score;
+    result.sends = sends;
+    result.colorChanges = color_changes;
+    result.reads = reads;
+    result.rounds = int(t);
+    result.droppedMessages = msgQueues.stats.dropped;
+    result.queueHighWater = msgQueues.stats.high_water;
+    result.truncated = truncated;
 }
 
 // Quick and dirty psuedo-code behind setting inputs and reading outputs
@@ -16,10 +16,22 @@
 #include <cmath>
 #include <queue>
 #include <fstream>
+#include <limits>
 // MABE includes
 #include "../AbstractWorld.h"
 // Local includes
 #include "./Graph.h"
+#include "./GraphLog.h"
+#include "./GraphChurn.h"
+#include "./GraphPipeline.h"
+#include "./MetricsLog.h"
+#include "./GraphPool.h"
+#include "./WorkStealingPool.h"
+#include "./ProcessPool.h"
+#include "./MessageQueues.h"
+#include "./PerfCounters.h"
+#include "./CounterRandom.h"
+#include "./PackedInputs.h"
 
 
 class GraphColorWorld : public AbstractWorld {
@@ -36,66 +48,352 @@ public:
     static std::shared_ptr <ParameterLink<int>> maximumColorsPL;
     static std::shared_ptr <ParameterLink<int>> useSetColorBitPL;
     static std::shared_ptr <ParameterLink<int>> useSetColorVetoBitPL;
+    static std::shared_ptr <ParameterLink<int>> messageQueueCapacityPL;
+    static std::shared_ptr <ParameterLink<std::string>> messageOverflowPolicyPL;
+    static std::shared_ptr <ParameterLink<int>> deltaInputsPL;
     static std::shared_ptr <ParameterLink<int>> minGraphNodesPL;
     static std::shared_ptr <ParameterLink<int>> maxGraphNodesPL;
     static std::shared_ptr <ParameterLink<double>> minEdgeChancePL;
     static std::shared_ptr <ParameterLink<double>> maxEdgeChancePL;
     static std::shared_ptr <ParameterLink<std::string>> graphOutputDirPL;;
+    static std::shared_ptr <ParameterLink<std::string>> graphGeneratorPL;
+    static std::shared_ptr <ParameterLink<double>> powerLawExponentPL;
+    static std::shared_ptr <ParameterLink<std::string>> graphFilePL;
+    static std::shared_ptr <ParameterLink<std::string>> graphLogFormatPL;
+    static std::shared_ptr <ParameterLink<int>> graphLogBufferMBPL;
+    static std::shared_ptr <ParameterLink<std::string>> metricsOutputPL;
+    static std::shared_ptr <ParameterLink<int>> graphPoolSizePL;
+    static std::shared_ptr <ParameterLink<std::string>> graphPoolFilesPL;
+    static std::shared_ptr <ParameterLink<std::string>> graphPoolOrderPL;
+    static std::shared_ptr <ParameterLink<int>> graphPoolGenerationsPerGraphPL;
+    static std::shared_ptr <ParameterLink<double>> dynamicGraphEdgeChurnPL;
+    static std::shared_ptr <ParameterLink<double>> dynamicGraphNodeChurnPL;
+    static std::shared_ptr <ParameterLink<int>> graphPrefetchPL;
+    static std::shared_ptr <ParameterLink<int>> normalizeGraphScorePL;
+    static std::shared_ptr <ParameterLink<int>> exactColoringBudgetPL;
+    static std::shared_ptr <ParameterLink<int>> evaluationThreadsPL;
+    static std::shared_ptr <ParameterLink<int>> evaluationProcessesPL;
+    static std::shared_ptr <ParameterLink<int>> nodeThreadsPL;
+    static std::shared_ptr <ParameterLink<std::string>> evaluationRandomPL;
+    static std::shared_ptr <ParameterLink<int>> racingEliteCountPL;
 
-    struct NodeMessage{
-        size_t senderID;
-        std::vector<double> senderAddr;
-        std::vector<double> contents;
-        NodeMessage(size_t id, size_t addrSize, size_t colSize){
-            senderID = id;
-            senderAddr.resize(addrSize, 0);
-            contents.resize(colSize, 0);
-            size_t bit = 1;
-            for(size_t i = 0; i < addrSize; ++i){
-                if(senderID & bit)
-                    senderAddr[i] = 1.0; 
-            }
-        }
-    };
-
+    bool deltaInputs;           // Deliveries only set the inputs that change
     bool useNewMsgBit, useSendMsgBit, useSendMsgVetoBit, useGetMsgBit, useGetMsgVetoBit, useSetColorBit, useSetColorVetoBit;
     size_t newMsgBitPos, sendMsgBitPos, sendMsgVetoBitPos, getMsgBitPos, getMsgVetoBitPos, setColorBitPos, setColorVetoBitPos;
     int maxColors = -1;
     int minGraphNodes, maxGraphNodes;
     double minEdgeChance, maxEdgeChance;
+    GraphGenerators::Type graphGenerator;
+    double powerLawExponent;
     size_t addressSize, colorSize;
+    size_t messageQueueCapacity;
+    MessageQueues::OverflowPolicy messageOverflowPolicy;
 
     int evaluationsPerGeneration;
     int agentLifetime;
 
+    // What a single evaluation produces, recorded into the org's dataMap afterwards
+    struct EvalResult{
+        double score, graphScore;
+        int sends, colorChanges, reads, rounds;
+        size_t droppedMessages, queueHighWater;
+        bool truncated;     // Stopped early by racing: score could no longer reach racingThreshold
+    };
+
+    // What a node's outputs ask for
+    struct NodeAction{
+        bool set_color = false;
+        bool send = false;
+        bool get = false;
+        uint32_t color_bits = 0;
+        size_t target = 0;
+    };
+
+    // Everything one worker mutates during an evaluation. Each context owns its own
+    // colors (and brain clones) on top of the shared, read-only topology in G.
+    struct EvalContext{
+        Graph G;
+        std::vector<std::shared_ptr<AbstractBrain>> cloneBrains;
+        std::weak_ptr<AbstractBrain> clonedBrain;   // The brain cloneBrains are copies of
+        MessageQueues msgQueues;
+        std::vector<size_t> nodeOrder;
+        std::vector<uint8_t> deliverMsgVec;
+        std::vector<NodeAction> actions;    // Decoded up front, with node threads
+        PackedInputs messageInputs;         // Sender and color inputs, with deltaInputs
+        PackedInputs newMsgInputs;          // The new message bit, with deltaInputs
+        std::vector<uint32_t> randomWords; // Filled from the counter-based stream
+#ifdef GRAPH_COLOR_ENABLE_PERF
+        PerfCounters perf;
+#endif
+    };
+
+    // The statistics a forked evaluation process gathered in its copy of contexts[0], sent
+    // back to the parent when it is done
+    struct WorkerReport{
+        MessageQueues::Stats messages;
+#ifdef GRAPH_COLOR_ENABLE_PERF
+        PerfCounters perf;
+#endif
+    };
+
+    int evaluationThreads;
+    std::shared_ptr<WorkStealingPool> pool;
+    int evaluationProcesses;
+    std::shared_ptr<ProcessPool<EvalResult, WorkerReport>> processPool; // Instead of pool, for brains that aren't thread-safe
+    WorkerReport forkedStats;   // Reported by forked processes, plus what contexts[0] held before each fork
+    int nodeThreads;
+    std::shared_ptr<WorkStealingPool> nodePool; // Splits the nodes of one evaluation across threads
+    static const size_t minNodeBlock = 256;     // Fewest nodes worth handing to a thread
+    bool counterRandom;         // Evaluations draw from CounterRandom streams instead of seeded mt19937s
+    uint32_t counterRandomKey;  // Drawn once from MABE's generator, so runs still follow its seed
+
+    // Racing: the first racingEliteCount organisms of a generation are evaluated in full, and the
+    // racingEliteCount-th best of their evaluation scores becomes racingThreshold. No later
+    // evaluation below it can be among the generation's top racingEliteCount, so the rest stop
+    // as soon as their best reachable score falls below it.
+    size_t racingEliteCount;    // 0 = off
+    double racingThreshold = -std::numeric_limits<double>::infinity();
+    std::vector<double> racingScores;
+    std::vector<EvalContext> contexts; // One per worker; contexts[0] is used by the serial path
+
     static std::shared_ptr <ParameterLink<std::string>> groupNamePL;
     static std::shared_ptr <ParameterLink<std::string>> brainNamePL;
 
 
     Graph G;
     std::string graphOutputDir;
-    std::ofstream graph_file;
+    GraphLog graphLog;
+    size_t generation = 0;
+    std::string graphFile; // If set, every generation is evaluated on this graph instead of a random one
+    GraphPool graphPool;   // If not empty, every generation is evaluated on a graph from here
+    double dynamicGraphEdgeChurn, dynamicGraphNodeChurn; // If either is > 0, each generation's graph is a changed copy of the last one
+    GraphPipeline graphPipeline; // Builds upcoming generations' graphs in the background, if running
+    uint64_t graphPipelineKey = 0;
+    std::shared_ptr<const GraphTopology> pipelineTopology; // Last graph the pipeline built (its thread only)
+    bool normalizeGraphScore;
+    MetricsLog metricsLog;      // Open unless metricsOutput is dataMap
+    bool metricsToDataMap;      // Every metric is appended to the dataMap, not just score
+    struct MetricsColumns{
+        MetricsLog::Column generation, organism, eval, score, graphScore, sends, colorChanges, reads, rounds,
+                           droppedMessages, queueHighWater, truncated;
+    } metricsColumns;
+    size_t bestKnownColors = 0; // Fewest colors a known coloring of the current graph uses (0 = unknown)
+#ifdef GRAPH_COLOR_ENABLE_PERF
+    std::ofstream perfFile;
+#endif
 
     GraphColorWorld(std::shared_ptr <ParametersTable> PT_ = nullptr);
 
     virtual ~GraphColorWorld(){
-        graph_file.close();
+        graphPipeline.stop();
+        graphLog.close();
+        metricsLog.close();
+        MessageQueues::Stats messageStats;
+        for(auto& ctx : contexts){
+            messageStats.merge(ctx.msgQueues.total_stats);
+            messageStats.merge(ctx.msgQueues.stats);
+        }
+        messageStats.merge(forkedStats.messages);
+        std::cout << messageStats.to_string() << std::endl;
     };
 
-    void evaluateSolo(std::shared_ptr <Organism> org, int analyze, int visualize, int debug);
+    void evaluateSolo(std::shared_ptr <Organism> org, size_t orgIndex, int analyze, int visualize, int debug);
+    void setRacingThreshold();
+    void evaluateParallel(std::vector<std::shared_ptr<Organism>>& population);
+    // Runs evaluationsPerGeneration evaluations of each brain on pool or processPool, with seeds
+    // drawn as evaluateSolo draws them; results are in (brain, eval) order
+    void evaluateBrains(const std::vector<std::shared_ptr<AbstractBrain>>& brains, std::vector<EvalResult>& results);
+    void runEvaluation(std::shared_ptr<AbstractBrain> originalBrain, uint32_t seed, size_t orgIndex, 
+                       size_t eval, EvalContext& ctx, EvalResult& result, int visualize){
+        (this->*evaluationFn)(originalBrain, seed, orgIndex, eval, ctx, result, visualize);
+    }
+
+    // The optional I/O bits, as a mask; runEvaluation runs the lifetime loop compiled for the
+    // configured mask, so unused bits cost no branches and bit positions are constants
+    enum IOFeature{
+        NEW_MSG_BIT         = 1 << 0,
+        SEND_MSG_BIT        = 1 << 1,
+        SEND_MSG_VETO_BIT   = 1 << 2,
+        GET_MSG_BIT         = 1 << 3,
+        GET_MSG_VETO_BIT    = 1 << 4,
+        SET_COLOR_BIT       = 1 << 5,
+        SET_COLOR_VETO_BIT  = 1 << 6
+    };
+    using EvaluationFn = void (GraphColorWorld::*)(std::shared_ptr<AbstractBrain>, uint32_t, size_t, size_t, 
+                                                   EvalContext&, EvalResult&, int);
+    EvaluationFn evaluationFn;
+    template<int Features>
+    void runEvaluationFor(std::shared_ptr<AbstractBrain> originalBrain, uint32_t seed, size_t orgIndex, 
+                          size_t eval, EvalContext& ctx, EvalResult& result, int visualize);
+    // Picks the instantiation for the configured bits (a veto bit only exists with its bit)
+    template<int Features> EvaluationFn selectEvaluationSetColor();
+    template<int Features> EvaluationFn selectEvaluationGet();
+    template<int Features> EvaluationFn selectEvaluationSend();
+    EvaluationFn selectEvaluation();
+    void openMetricsLog(const std::string& path);
+    void recordResult(std::shared_ptr <Organism> org, size_t eval, const EvalResult& result, int visualize);
+
+    // Runs body(begin, end) over contiguous blocks of nodes [0, numNodes), on nodePool's
+    // threads if there is one and the graph is big enough; blocks must be independent
+    template<class Body>
+    void forNodeBlocks(size_t numNodes, const Body& body){
+        size_t numBlocks = 1;
+        if(nodePool != nullptr)
+            numBlocks = std::min(nodePool->size() * 4, (numNodes + minNodeBlock - 1) / minNodeBlock);
+        if(numBlocks <= 1){
+            body(0, numNodes);
+            return;
+        }
+        size_t blockSize = (numNodes + numBlocks - 1) / numBlocks;
+        nodePool->run(numBlocks, [&](size_t block, size_t){
+            body(block * blockSize, std::min(numNodes, (block + 1) * blockSize));
+        });
+    }
+
+    // Every evaluation gets its own seed, drawn in (organism, eval) order from MABE's 
+    // generator, so the serial and parallel paths produce identical results. Counter-based
+    // streams are keyed by (generation, organism, eval) instead and need no seed.
+    uint32_t nextEvaluationSeed(){
+        if(counterRandom)
+            return 0;
+        return (uint32_t)Random::getInt(0, std::numeric_limits<int>::max());
+    }
+
+    // Draws a random graph's parameters from MABE's generator and builds it
+    GraphLog::Entry makeRandomGraph(size_t logGeneration){
+        GraphLog::Entry entry;
+        entry.generation = logGeneration;
+        entry.generator = GraphGenerators::type_to_string(graphGenerator);
+        entry.power_law_exponent = powerLawExponent;
+        // Drawn edge chance first: the order earlier builds drew them in, so legacy graphs still match
+        entry.edge_chance = Random::getDouble(minEdgeChance, maxEdgeChance);
+        entry.num_nodes = Random::getInt(minGraphNodes, maxGraphNodes);
+        // Legacy graphs draw from MABE's generator directly, so they have no seed of their own
+        if(graphGenerator != GraphGenerators::LEGACY)
+            entry.seed = (uint64_t)Random::getInt(0, std::numeric_limits<int>::max());
+        entry.topology = G.make_random_topology(entry.num_nodes, entry.edge_chance, graphGenerator, 
+                                                powerLawExponent, entry.seed);
+        return entry;
+    }
+
+    bool dynamicGraphs() const{
+        return dynamicGraphEdgeChurn > 0 || dynamicGraphNodeChurn > 0;
+    }
+
+    // Draws random churn for topology, without applying it; only the diff is logged
+    GraphLog::Entry churnGraph(const GraphTopology& topology, size_t logGeneration, uint64_t seed){
+        GraphLog::Entry entry;
+        entry.generation = logGeneration;
+        entry.generator = "churn";
+        entry.num_nodes = topology.node_count;
+        entry.seed = seed;
+        entry.diff = std::make_shared<GraphChurn::Diff>(GraphChurn::random_churn(topology, 
+            dynamicGraphEdgeChurn, dynamicGraphNodeChurn, entry.seed));
+        return entry;
+    }
+
+    // Applies churn to the world's graph, in place once nothing else holds its topology
+    GraphLog::Entry churnWorldGraph(uint64_t seed){
+        GraphLog::Entry entry = churnGraph(*G.topology, generation, seed);
+        for(auto& ctx : contexts)
+            ctx.G.release_topology();
+        G.apply_diff(*entry.diff);
+        return entry;
+    }
+
+    // Builds a generation's graph on the pipeline's thread. Parameters and seeds come from a
+    // generator keyed by (graphPipelineKey, generation), not MABE's, which evaluation is using.
+    GraphPipeline::Graph produceGraph(size_t logGeneration){
+        GraphGenerators::SeededRandom rand(graphPipelineKey ^ (logGeneration * 0x9E3779B97F4A7C15ull));
+        GraphPipeline::Graph graph;
+        GraphLog::Entry& entry = graph.entry;
+        if(dynamicGraphs() && pipelineTopology != nullptr){
+            // The world is evaluating on pipelineTopology, so the churned graph is a copy
+            entry = churnGraph(*pipelineTopology, logGeneration, rand.rng() >> 33);
+            entry.topology = GraphChurn::apply(*pipelineTopology, *entry.diff, G.bitset_policy);
+        }
+        else{
+            entry.generation = logGeneration;
+            entry.generator = GraphGenerators::type_to_string(graphGenerator);
+            entry.power_law_exponent = powerLawExponent;
+            entry.edge_chance = minEdgeChance + (maxEdgeChance - minEdgeChance) * rand.get_double();
+            entry.num_nodes = rand.get_int(minGraphNodes, maxGraphNodes);
+            entry.seed = rand.rng() >> 33;
+            entry.topology = G.make_random_topology(entry.num_nodes, entry.edge_chance, graphGenerator, 
+                                                    powerLawExponent, entry.seed);
+        }
+        pipelineTopology = entry.topology;
+        if(normalizeGraphScore)
+            graph.best_colors = GraphPool::describe(entry.topology, entry.generator, 
+                                                    graphPool.exact_search_nodes).best_colors();
+        return graph;
+    }
 
     virtual void evaluate(std::map <std::string, std::shared_ptr<Group>> &groups, int analyze, int visualize, int debug) {
-        // Randomize the graph
-        G.randomize(
-            Random::getInt(minGraphNodes, maxGraphNodes), 
-            Random::getDouble(minEdgeChance, maxEdgeChance));
-        graph_file << G.get_csv_string() << std::endl;
+        // Pick the graph: from the pool, from the pipeline, last generation's with churn applied
+        // (dynamic graphs), or a new random one (a loaded graph is kept). Pool and loaded graphs
+        // were logged when they were built or loaded.
+        if(!graphPool.empty()){
+            const GraphPool::Entry& entry = graphPool.pick(generation);
+            if(G.topology != entry.topology)
+                G.set_topology(entry.topology);
+            bestKnownColors = entry.best_colors();
+        }
+        else if(graphPipeline.running() && (graphFile.empty() || generation > 0)){
+            // Built while the last generation was evaluated
+            GraphPipeline::Graph graph = graphPipeline.take(generation);
+            G.set_topology(graph.entry.topology);
+            graphLog.log(graph.entry);
+            bestKnownColors = graph.best_colors;
+        }
+        else if(graphFile.empty() || (dynamicGraphs() && generation > 0)){
+            GraphLog::Entry entry;
+            if(dynamicGraphs() && generation > 0){
+                entry = churnWorldGraph((uint64_t)Random::getInt(0, std::numeric_limits<int>::max()));
+            }
+            else{
+                entry = makeRandomGraph(generation);
+                G.set_topology(entry.topology);
+            }
+            graphLog.log(entry);
+            if(normalizeGraphScore)
+                bestKnownColors = GraphPool::describe(G.topology, entry.generator, 
+                                                      graphPool.exact_search_nodes).best_colors();
+        }
+        ++generation;
         int popSize = groups[groupNamePL->get(PT)]->population.size();
-        //for (int i = 0; i < popSize; i++) {
-        for (auto org:groups[groupNamePL->get(PT)]->population){
-            evaluateSolo(org, analyze, visualize, debug);
+        racingThreshold = -std::numeric_limits<double>::infinity();
+        racingScores.clear();
+        // Printing from several workers would interleave, so visualize/debug stay serial
+        if((pool != nullptr || processPool != nullptr) && !visualize && !debug){
+            evaluateParallel(groups[groupNamePL->get(PT)]->population);
         }
+        else{
+            auto& population = groups[groupNamePL->get(PT)]->population;
+            for (size_t i = 0; i < population.size(); i++) {
+                evaluateSolo(population[i], i, analyze, visualize, debug);
+                if (i + 1 == racingEliteCount)
+                    setRacingThreshold();
+            }
+        }
+        // One metrics block per generation, so the file is current between generations
+        metricsLog.flush();
+        GRAPH_COLOR_PERF(writePerfRow());
+    }
+
+#ifdef GRAPH_COLOR_ENABLE_PERF
+    // Sums every worker's counters for the generation that just finished into one perf.csv row
+    void writePerfRow(){
+        PerfCounters total;
+        for(auto& ctx : contexts){
+            total.merge(ctx.perf);
+            ctx.perf = PerfCounters();
+        }
+        total.merge(forkedStats.perf);
+        forkedStats.perf = PerfCounters();
+        total.write_row(perfFile, generation - 1);
     }
+#endif
 
     virtual std::unordered_map <std::string, std::unordered_set<std::string>> requiredGroups() override {
         // TODO: Do we want extra, room for arbitrary data in messages? 
@@ -131,14 +429,29 @@ public:
         // TODO: add color here
 
 
-        //Calculate the number of input bits required
+        size_t inputSize = brainInputSize();
+        size_t outputSize = brainOutputSize();
+        std::cout << "Input bits: " << inputSize << std::endl;
+        std::cout << "Output bits: " << outputSize << std::endl;
+        return {{groupNamePL->get(PT), 
+            {"B:" + brainNamePL->get(PT) + "," + std::to_string(inputSize) + 
+             "," + std::to_string(outputSize) }
+            }};
+    }
+    
+    //Calculate the number of input bits required
+    size_t brainInputSize() const{
         size_t inputSize = 0;
         if(useNewMsgBit)
             ++inputSize;
         inputSize += addressSize;                   // To address nodes in binary
         inputSize += colorSize;                     // Allow messages to pass a color
                                                     //    Number of colors <= the number of nodes
-        //Calculate the number of output bits required
+        return inputSize;
+    }
+
+    //Calculate the number of output bits required
+    size_t brainOutputSize() const{
         size_t outputSize = 0;
         if(useSendMsgBit)
             ++outputSize;
@@ -155,14 +468,9 @@ public:
 
         outputSize += addressSize;  // To address nodes in binary
         outputSize += colorSize;    // To allow for colors to be sent
-        std::cout << "Input bits: " << inputSize << std::endl;
-        std::cout << "Output bits: " << outputSize << std::endl;
-        return {{groupNamePL->get(PT), 
-            {"B:" + brainNamePL->get(PT) + "," + std::to_string(inputSize) + 
-             "," + std::to_string(outputSize) }
-            }};
+        return outputSize;
     }
-    
+
     void verifyGraphGenVars(){
         if(minGraphNodes < 1){
             std::cout << "minGraphNodes must be >= 1, was passed " << minGraphNodes << std::endl;
@@ -192,6 +500,44 @@ public:
                       << maxEdgeChance << " vs " << minEdgeChance << std::endl;
             exit(-1);
         }
+        if(graphLog.format == GraphLog::SEED && graphFile.empty() && graphGenerator == GraphGenerators::LEGACY){
+            std::cout << "graphLogFormat seed cannot reproduce legacy graphs; use another graphGenerator "
+                      << "or graphLogFormat" << std::endl;
+            exit(-1);
+        }
+        if(graphPoolSizePL->get(PT) < 0){
+            std::cout << "graphPoolSize must be >= 0, was passed " << graphPoolSizePL->get(PT) << std::endl;
+            exit(-1);
+        }
+        if(exactColoringBudgetPL->get(PT) < 0){
+            std::cout << "exactColoringBudget must be >= 0, was passed " << exactColoringBudgetPL->get(PT) << std::endl;
+            exit(-1);
+        }
+        if(graphPoolGenerationsPerGraphPL->get(PT) < 1){
+            std::cout << "graphPoolGenerationsPerGraph must be >= 1, was passed " 
+                      << graphPoolGenerationsPerGraphPL->get(PT) << std::endl;
+            exit(-1);
+        }
+        if(!graphFile.empty() && (graphPoolSizePL->get(PT) > 0 || !graphPoolFilesPL->get(PT).empty())){
+            std::cout << "graphFile cannot be combined with a graph pool (graphPoolSize or graphPoolFiles)" 
+                      << std::endl;
+            exit(-1);
+        }
+        if(dynamicGraphEdgeChurn < 0 || dynamicGraphEdgeChurn > 1 || dynamicGraphNodeChurn < 0 || dynamicGraphNodeChurn > 1){
+            std::cout << "dynamicGraphEdgeChurn and dynamicGraphNodeChurn must be in [0, 1], were passed " 
+                      << dynamicGraphEdgeChurn << " and " << dynamicGraphNodeChurn << std::endl;
+            exit(-1);
+        }
+        if(dynamicGraphs() && (graphPoolSizePL->get(PT) > 0 || !graphPoolFilesPL->get(PT).empty())){
+            std::cout << "Dynamic graphs (dynamicGraphEdgeChurn or dynamicGraphNodeChurn) cannot be combined "
+                      << "with a graph pool (graphPoolSize or graphPoolFiles)" << std::endl;
+            exit(-1);
+        }
+        if(graphGenerator == GraphGenerators::POWER_LAW && powerLawExponent <= 1){
+            std::cout << "powerLawExponent must be > 1, was passed " 
+                      << powerLawExponent << std::endl;
+            exit(-1);
+        }
     }
 };
 
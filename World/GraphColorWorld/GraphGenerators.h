@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+// MABE includes
+#include "../../Utilities/Random.h"
+
+// Random graph families, each producing an undirected edge list that GraphTopology::build
+// turns into adjacency in one pass. Every family takes the same edge_chance as the original
+// generator and aims for the same expected average degree, edge_chance * (num_nodes - 1),
+// so minEdgeChance/maxEdgeChance mean the same thing whichever family is used.
+// Apart from LEGACY, each generator costs O(N + E) rather than O(N^2).
+//
+// LEGACY draws from MABE's shared generator, as it always has. The other families draw
+// from a SeededRandom, so a graph is fully determined by (family, N, edge chance,
+// exponent, seed) and can be regenerated from those alone.
+namespace GraphGenerators{
+    using EdgeList = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    // A small generator whose output is the same on every platform and standard library
+    // (std::uniform_*_distribution makes no such promise)
+    struct SeededRandom{
+        std::mt19937_64 rng;
+
+        SeededRandom(uint64_t seed) : rng(seed){
+        }
+
+        // In [0, 1)
+        double get_double(){
+            return (rng() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        // In [lo, hi]
+        int get_int(int lo, int hi){
+            return lo + (int)(rng() % (uint64_t)(hi - lo + 1));
+        }
+
+        // In [0, n), for ranges too big for an int (same draws as get_int(0, n - 1) otherwise)
+        uint64_t get_index(uint64_t n){
+            return rng() % n;
+        }
+    };
+
+    enum Type{
+        LEGACY,     // One draw per node pair, exactly as earlier versions (reproduces their graphs)
+        GNP,        // Erdos-Renyi G(n, p), skipping over non-edges with geometric gaps
+        REGULAR,    // Configuration model: every node has degree <= d, most exactly d
+        GEOMETRIC,  // Random geometric graph: nodes in the unit square, edges within a radius
+        POWER_LAW   // Chung-Lu graph with a power-law expected degree sequence
+    };
+
+    inline Type type_from_string(const std::string& name){
+        if(name == "legacy")
+            return LEGACY;
+        if(name == "gnp")
+            return GNP;
+        if(name == "regular")
+            return REGULAR;
+        if(name == "geometric")
+            return GEOMETRIC;
+        if(name == "powerlaw")
+            return POWER_LAW;
+        std::cout << "Unknown graph generator \"" << name << "\" (expected legacy, gnp, "
+                  << "regular, geometric or powerlaw)" << std::endl;
+        exit(-1);
+    }
+
+    // Number of pairs to skip before the next edge, for an edge probability of p in (0, 1)
+    inline size_t geometric_skip(double log_one_minus_p, SeededRandom& rand){
+        double r = rand.get_double();
+        double skip = std::log(1.0 - r) / log_one_minus_p;
+        // Tiny p can give skips too large for size_t; anything this big ends the walk anyway
+        return skip < 1e15 ? (size_t)skip : (size_t)1e15;
+    }
+
+    // Note: like the original generator, never connects the last node
+    inline EdgeList legacy(size_t num_nodes, double edge_chance){
+        EdgeList edges;
+        double rand_pct;
+        for(size_t a = 0; a < num_nodes - 1; ++a){
+            for(size_t b = a + 1; b < num_nodes - 1; ++b){
+                rand_pct = Random::getDouble(0,1); // In [0, 1) which should be fine
+                if(rand_pct <= edge_chance){
+                    edges.push_back({a, b});
+                }
+            }
+        }
+        return edges;
+    }
+
+    // Batagelj & Brandes (2005): walk the lower triangle, jumping straight to the next edge
+    inline EdgeList gnp(size_t num_nodes, double edge_chance, SeededRandom& rand){
+        EdgeList edges;
+        if(edge_chance <= 0 || num_nodes < 2)
+            return edges;
+        edges.reserve((size_t)(edge_chance * num_nodes * (num_nodes - 1) / 2 * 1.1));
+        if(edge_chance >= 1){
+            for(size_t a = 1; a < num_nodes; ++a)
+                for(size_t b = 0; b < a; ++b)
+                    edges.push_back({a, b});
+            return edges;
+        }
+        double log_q = std::log(1.0 - edge_chance);
+        size_t a = 1, b = (size_t)-1;
+        while(a < num_nodes){
+            b += 1 + geometric_skip(log_q, rand);
+            while(b >= a && a < num_nodes){
+                b -= a;
+                ++a;
+            }
+            if(a < num_nodes)
+                edges.push_back({a, b});
+        }
+        return edges;
+    }
+
+    // Pairs up degree * num_nodes stubs at random. Self loops and repeated pairs are dropped
+    // (GraphTopology::build removes duplicates), so degrees are bounded by, and mostly equal to, degree.
+    inline EdgeList regular(size_t num_nodes, double edge_chance, SeededRandom& rand){
+        EdgeList edges;
+        if(num_nodes < 2)
+            return edges;
+        size_t degree = (size_t)std::lround(edge_chance * (num_nodes - 1));
+        std::vector<uint32_t> stubs;
+        stubs.reserve(num_nodes * degree);
+        for(size_t n = 0; n < num_nodes; ++n)
+            for(size_t i = 0; i < degree; ++i)
+                stubs.push_back(n);
+        for(size_t i = stubs.size(); i > 1; --i)
+            std::swap(stubs[i - 1], stubs[rand.get_index(i)]);
+        edges.reserve(stubs.size() / 2);
+        for(size_t i = 0; i + 1 < stubs.size(); i += 2){
+            if(stubs[i] != stubs[i + 1])
+                edges.push_back({stubs[i], stubs[i + 1]});
+        }
+        return edges;
+    }
+
+    // Nodes are dropped uniformly in the unit square and joined when closer than a radius r,
+    // with pi * r^2 = edge_chance (ignoring boundary effects). Points are bucketed into a
+    // grid of cells at least r wide, so only neighboring cells are compared.
+    inline EdgeList geometric(size_t num_nodes, double edge_chance, SeededRandom& rand){
+        EdgeList edges;
+        if(edge_chance <= 0 || num_nodes < 2)
+            return edges;
+        double radius = std::sqrt(edge_chance / M_PI);
+        std::vector<double> x(num_nodes), y(num_nodes);
+        for(size_t n = 0; n < num_nodes; ++n){
+            x[n] = rand.get_double();
+            y[n] = rand.get_double();
+        }
+        // Cap the grid at ~1 cell per node so tiny radii don't allocate huge grids
+        size_t cells = std::max((size_t)1, std::min((size_t)(1.0 / radius),
+                                                    (size_t)std::sqrt((double)num_nodes)));
+        std::vector<size_t> cell_start(cells * cells + 1, 0);
+        std::vector<uint32_t> cell_nodes(num_nodes);
+        auto cell_of = [&](size_t n){
+            size_t cx = std::min((size_t)(x[n] * cells), cells - 1);
+            size_t cy = std::min((size_t)(y[n] * cells), cells - 1);
+            return cy * cells + cx;
+        };
+        for(size_t n = 0; n < num_nodes; ++n)
+            ++cell_start[cell_of(n) + 1];
+        for(size_t c = 0; c < cells * cells; ++c)
+            cell_start[c + 1] += cell_start[c];
+        std::vector<size_t> fill(cell_start.begin(), cell_start.end() - 1);
+        for(size_t n = 0; n < num_nodes; ++n)
+            cell_nodes[fill[cell_of(n)]++] = n;
+
+        double r2 = radius * radius;
+        // Own cell plus the four "forward" neighbors, so each pair of cells is visited once
+        const int offsets[5][2] = {{0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+        for(size_t cy = 0; cy < cells; ++cy){
+            for(size_t cx = 0; cx < cells; ++cx){
+                size_t c = cy * cells + cx;
+                for(auto& off : offsets){
+                    int nx = (int)cx + off[0], ny = (int)cy + off[1];
+                    if(nx < 0 || ny < 0 || nx >= (int)cells || ny >= (int)cells)
+                        continue;
+                    size_t d = ny * cells + nx;
+                    for(size_t i = cell_start[c]; i < cell_start[c + 1]; ++i){
+                        uint32_t a = cell_nodes[i];
+                        size_t j = (d == c) ? i + 1 : cell_start[d];
+                        for(; j < cell_start[d + 1]; ++j){
+                            uint32_t b = cell_nodes[j];
+                            double dx = x[a] - x[b], dy = y[a] - y[b];
+                            if(dx * dx + dy * dy < r2)
+                                edges.push_back({a, b});
+                        }
+                    }
+                }
+            }
+        }
+        return edges;
+    }
+
+    // Chung-Lu graph: node i gets expected degree w_i proportional to (i + 1)^(-1 / (exponent - 1)),
+    // which gives a degree distribution with tail ~ k^-exponent. Sampled with the O(N + E)
+    // method of Miller & Hagberg (2011), which skips geometrically over the sorted weights.
+    inline EdgeList power_law(size_t num_nodes, double edge_chance, double exponent, SeededRandom& rand){
+        EdgeList edges;
+        if(edge_chance <= 0 || num_nodes < 2)
+            return edges;
+        std::vector<double> weights(num_nodes);
+        double total = 0;
+        for(size_t n = 0; n < num_nodes; ++n){
+            weights[n] = std::pow((double)(n + 1), -1.0 / (exponent - 1.0));
+            total += weights[n];
+        }
+        // Scale so the mean expected degree matches the other families
+        double scale = edge_chance * (num_nodes - 1) / (total / num_nodes);
+        for(auto& w : weights)
+            w *= scale;
+        total *= scale;
+
+        for(size_t u = 0; u + 1 < num_nodes; ++u){
+            size_t v = u + 1;
+            double p = std::min(weights[u] * weights[v] / total, 1.0);
+            while(v < num_nodes && p > 0){
+                if(p < 1)
+                    v += geometric_skip(std::log(1.0 - p), rand);
+                if(v < num_nodes){
+                    double q = std::min(weights[u] * weights[v] / total, 1.0);
+                    if(rand.get_double() < q / p)
+                        edges.push_back({u, v});
+                    p = q;
+                    ++v;
+                }
+            }
+        }
+        return edges;
+    }
+
+    // seed is unused by LEGACY, which draws from MABE's generator
+    inline EdgeList generate(Type type, size_t num_nodes, double edge_chance, double power_law_exponent = 2.5,
+                             uint64_t seed = 0){
+        SeededRandom rand(seed);
+        switch(type){
+            case GNP: return gnp(num_nodes, edge_chance, rand);
+            case REGULAR: return regular(num_nodes, edge_chance, rand);
+            case GEOMETRIC: return geometric(num_nodes, edge_chance, rand);
+            case POWER_LAW: return power_law(num_nodes, edge_chance, power_law_exponent, rand);
+            default: return legacy(num_nodes, edge_chance);
+        }
+    }
+
+    inline std::string type_to_string(Type type){
+        switch(type){
+            case GNP: return "gnp";
+            case REGULAR: return "regular";
+            case GEOMETRIC: return "geometric";
+            case POWER_LAW: return "powerlaw";
+            default: return "legacy";
+        }
+    }
+}
@@ -0,0 +1,616 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+// POSIX, for memory-mapping binary graphs
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// Local includes
+#include "./GraphTopology.h"
+
+// Reading and writing graph files.
+//
+// The binary format (.gcg) is the CSR arrays of a GraphTopology written out as-is, so
+// it can be memory-mapped and used directly as the topology with no parsing:
+//      Header (64 bytes)       magic "GCGRAPH1", then uint64 node_count, edge_count,
+//                              num_directed (length of the neighbor array), rest zero
+//      uint64 offsets[node_count + 1]
+//      uint32 neighbors[num_directed]
+// All values are little-endian (native on the machines we run on).
+//
+// Text formats are parsed in large chunks, with each chunk split at line boundaries
+// and the pieces parsed in parallel:
+//      .col            DIMACS ("p edge N M" then "e u v", 1-based)
+//      .graph/.metis   METIS adjacency lists (line i lists the neighbors of node i, 1-based)
+//      .mtx            Matrix Market coordinate format (diagonal entries are dropped)
+//      anything else   The repo's original format: "N M" then M lines of "a b", 0-based
+// Errors are reported and exit, like the rest of the world's configuration checks.
+namespace GraphIO{
+    using EdgeList = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    const char binary_magic[8] = {'G', 'C', 'G', 'R', 'A', 'P', 'H', '1'};
+    const size_t binary_header_size = 64;
+    const size_t chunk_size = 64 << 20;
+    const uint64_t max_node_count = (uint64_t)UINT32_MAX + 1; // Node ids are uint32
+
+    struct BinaryHeader{
+        char magic[8];
+        uint64_t node_count, edge_count, num_directed;
+        uint64_t reserved[4];
+    };
+    static_assert(sizeof(BinaryHeader) == binary_header_size, "Binary graph header must be 64 bytes");
+
+    inline void fail(const std::string& filename, const std::string& message){
+        std::cout << "Error reading graph " << filename << ": " << message << std::endl;
+        exit(-1);
+    }
+
+    inline void check_node_count(const std::string& filename, uint64_t num_nodes){
+        if(num_nodes > max_node_count)
+            fail(filename, std::to_string(num_nodes) + " nodes is more than node ids can address");
+    }
+
+    inline bool ends_with(const std::string& s, const std::string& suffix){
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Writes one binary graph image; several can be written back to back into one stream
+    inline void write_binary(const GraphTopology& topo, std::ostream& out){
+        BinaryHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, binary_magic, sizeof(header.magic));
+        header.node_count = topo.node_count;
+        header.edge_count = topo.edge_count;
+        header.num_directed = topo.num_directed_edges();
+        out.write((const char*)&header, sizeof(header));
+        if(!topo.patched()){
+            out.write((const char*)topo.row_offsets, (topo.node_count + 1) * sizeof(uint64_t));
+            out.write((const char*)topo.row_neighbors, header.num_directed * sizeof(uint32_t));
+            return;
+        }
+        // Patched rows aren't packed, so they are packed on the way out
+        uint64_t offset = 0;
+        for(size_t n = 0; n <= topo.node_count; ++n){
+            out.write((const char*)&offset, sizeof(offset));
+            offset += n < topo.node_count ? topo.degree(n) : 0;
+        }
+        for(size_t n = 0; n < topo.node_count; ++n)
+            out.write((const char*)topo.neighbors_begin(n), topo.degree(n) * sizeof(uint32_t));
+    }
+
+    inline void save_binary(const GraphTopology& topo, const std::string& filename){
+        std::ofstream fp(filename, std::ios::out | std::ios::binary);
+        if(!fp.is_open()){
+            std::cout << "Error! Could not open " << filename << " for writing" << std::endl;
+            exit(-1);
+        }
+        write_binary(topo, fp);
+        if(!fp.good()){
+            std::cout << "Error! Failed while writing " << filename << std::endl;
+            exit(-1);
+        }
+    }
+
+    // One graph.csv row in the original format: "N,E,"[dense N x N adjacency matrix]""
+    inline std::string to_matrix_csv(const GraphTopology& topo){
+        std::ostringstream oss;
+        oss << topo.node_count;
+        oss << ",";
+        oss << topo.edge_count;
+        oss << ",";
+        oss << "\"[";
+        for(size_t a = 0; a < topo.node_count; ++a){
+            // Rows are sorted, so walk the neighbor list alongside the columns
+            const uint32_t* next = topo.neighbors_begin(a);
+            for(size_t b = 0; b < topo.node_count; ++b){
+                if(a != 0 || b != 0)
+                    oss << ",";
+                bool is_neighbor = next != topo.neighbors_end(a) && *next == b;
+                if(is_neighbor)
+                    ++next;
+                oss << (size_t)is_neighbor;
+            }
+        }
+        oss << "]\"";
+        return oss.str();
+    }
+
+    // Edge list as "[[a,b],[a,c],...]" with a < b (readable with json.loads)
+    inline std::string to_edge_list_string(const GraphTopology& topo){
+        std::ostringstream oss;
+        oss << "[";
+        bool first = true;
+        for(size_t a = 0; a < topo.node_count; ++a){
+            for(const uint32_t* b = topo.neighbors_begin(a); b != topo.neighbors_end(a); ++b){
+                if(*b < a)
+                    continue;
+                if(!first)
+                    oss << ",";
+                oss << "[" << a << "," << *b << "]";
+                first = false;
+            }
+        }
+        oss << "]";
+        return oss.str();
+    }
+
+    // Maps a binary graph and attaches the topology to the mapping (no copy is made)
+    inline std::shared_ptr<GraphTopology> map_binary(const std::string& filename,
+            GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO){
+        int fd = open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            fail(filename, "could not open file");
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (size_t)st.st_size < binary_header_size){
+            close(fd);
+            fail(filename, "file is too small to be a binary graph");
+        }
+        size_t length = st.st_size;
+        void* data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(data == MAP_FAILED)
+            fail(filename, "mmap failed");
+        std::shared_ptr<const void> mapping(data, [length](const void* p){ munmap((void*)p, length); });
+
+        const BinaryHeader* header = (const BinaryHeader*)data;
+        if(std::memcmp(header->magic, binary_magic, sizeof(binary_magic)) != 0)
+            fail(filename, "not a binary graph (bad magic)");
+        // Sizes are checked against what is left of the file one array at a time, so a
+        // corrupt header can't overflow the arithmetic
+        uint64_t node_count = header->node_count, num_directed = header->num_directed;
+        check_node_count(filename, node_count);
+        size_t available = length - binary_header_size;
+        if(node_count + 1 > available / sizeof(uint64_t))
+            fail(filename, "file is truncated");
+        available -= (node_count + 1) * sizeof(uint64_t);
+        if(num_directed > available / sizeof(uint32_t))
+            fail(filename, "file is truncated");
+        const uint64_t* offsets = (const uint64_t*)((const char*)data + binary_header_size);
+        const uint32_t* neighbors = (const uint32_t*)(offsets + node_count + 1);
+        if(offsets[0] != 0 || offsets[node_count] != num_directed)
+            fail(filename, "offsets do not match the neighbor count");
+        // Every row has to lie inside the neighbor array, hold only real nodes and be strictly
+        // increasing (check_neighbors binary searches it)
+        for(uint64_t n = 0; n < node_count; ++n){
+            if(offsets[n + 1] < offsets[n])
+                fail(filename, "offsets decrease at node " + std::to_string(n));
+        }
+        uint32_t max_neighbor = 0;
+        for(uint64_t n = 0; n < node_count; ++n){
+            for(uint64_t i = offsets[n]; i < offsets[n + 1]; ++i){
+                if(i > offsets[n] && neighbors[i] <= neighbors[i - 1])
+                    fail(filename, "neighbors of node " + std::to_string(n) + " are not sorted");
+                max_neighbor = std::max(max_neighbor, neighbors[i]);
+            }
+        }
+        if(num_directed > 0 && max_neighbor >= node_count)
+            fail(filename, "neighbor " + std::to_string(max_neighbor) + " is >= the node count " 
+                 + std::to_string(node_count));
+
+        auto topo = std::make_shared<GraphTopology>(node_count);
+        topo->attach(offsets, neighbors, header->edge_count, mapping, policy);
+        return topo;
+    }
+
+    inline bool is_binary(const std::string& filename){
+        std::ifstream fp(filename, std::ios::in | std::ios::binary);
+        char magic[sizeof(binary_magic)];
+        return fp.read(magic, sizeof(magic)) && std::memcmp(magic, binary_magic, sizeof(magic)) == 0;
+    }
+
+    // Small, allocation-free tokenizer over [pos, end)
+    struct Cursor{
+        const char* pos;
+        const char* end;
+
+        void skip_blanks(){
+            while(pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r'))
+                ++pos;
+        }
+        bool at_line_end(){
+            skip_blanks();
+            return pos >= end || *pos == '\n';
+        }
+        // Fails on a number too big for 64 bits rather than wrapping
+        bool read_uint(uint64_t& value){
+            skip_blanks();
+            if(pos >= end || *pos < '0' || *pos > '9')
+                return false;
+            value = 0;
+            while(pos < end && *pos >= '0' && *pos <= '9'){
+                uint64_t digit = *pos++ - '0';
+                if(value > (UINT64_MAX - digit) / 10)
+                    return false;
+                value = value * 10 + digit;
+            }
+            return true;
+        }
+        // Skips any non-blank token (e.g., a floating point weight)
+        bool skip_token(){
+            skip_blanks();
+            if(pos >= end || *pos == '\n')
+                return false;
+            while(pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n')
+                ++pos;
+            return true;
+        }
+        void next_line(){
+            const char* nl = (const char*)memchr(pos, '\n', end - pos);
+            pos = nl ? nl + 1 : end;
+        }
+        std::string current_line() const{
+            const char* nl = (const char*)memchr(pos, '\n', end - pos);
+            return std::string(pos, nl ? nl : end);
+        }
+    };
+
+    // What one piece of a chunk produced
+    struct Piece{
+        EdgeList edges;
+        size_t lines = 0;       // Format-specific line count (e.g., vertex lines for METIS)
+        std::string error;      // First bad line, if any
+        std::string error_reason = "malformed line";
+        uint64_t header_nodes = 0, header_edges = 0;
+        bool has_header = false;
+    };
+
+    inline size_t default_threads(){
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Splits [begin, end) at line boundaries into up to num_threads pieces and runs
+    // parse(piece_index, piece_begin, piece_end, piece) on each in parallel
+    template<class Parser>
+    void parse_pieces(const char* begin, const char* end, size_t num_threads,
+                      std::vector<Piece>& pieces, const Parser& parse){
+        std::vector<const char*> bounds = {begin};
+        size_t target = (end - begin) / num_threads + 1;
+        while(bounds.back() < end){
+            const char* cut = bounds.back() + target;
+            if(cut >= end){
+                bounds.push_back(end);
+                break;
+            }
+            const char* nl = (const char*)memchr(cut, '\n', end - cut);
+            bounds.push_back(nl ? nl + 1 : end);
+        }
+        size_t num_pieces = bounds.size() - 1;
+        pieces.assign(num_pieces, Piece());
+        std::vector<std::thread> threads;
+        for(size_t i = 1; i < num_pieces; ++i)
+            threads.push_back(std::thread([&, i]{ parse(i, bounds[i], bounds[i + 1], pieces[i]); }));
+        if(num_pieces > 0)
+            parse(0, bounds[0], bounds[1], pieces[0]);
+        for(auto& t : threads)
+            t.join();
+    }
+
+    // Streams the file in chunks that end on line boundaries, so the whole text never
+    // has to be in memory at once. on_chunk(begin, end, is_first_chunk) is called per chunk.
+    template<class ChunkHandler>
+    void stream_chunks(const std::string& filename, const ChunkHandler& on_chunk){
+        FILE* fp = fopen(filename.c_str(), "rb");
+        if(fp == nullptr)
+            fail(filename, "could not open file");
+        std::vector<char> buffer;
+        size_t carried = 0;
+        bool first = true;
+        while(true){
+            buffer.resize(carried + chunk_size);
+            size_t got = fread(buffer.data() + carried, 1, chunk_size, fp);
+            size_t filled = carried + got;
+            bool eof = got < chunk_size;
+            if(filled == 0)
+                break;
+            // Hold back the partial last line for the next chunk
+            size_t usable = filled;
+            if(!eof){
+                const char* last_nl = nullptr;
+                for(size_t i = filled; i > 0; --i){
+                    if(buffer[i - 1] == '\n'){
+                        last_nl = buffer.data() + i - 1;
+                        break;
+                    }
+                }
+                if(last_nl == nullptr){
+                    carried = filled; // A single line longer than a chunk; keep reading
+                    continue;
+                }
+                usable = last_nl - buffer.data() + 1;
+            }
+            on_chunk(buffer.data(), buffer.data() + usable, first);
+            first = false;
+            carried = filled - usable;
+            std::memmove(buffer.data(), buffer.data() + usable, carried);
+            if(eof)
+                break;
+        }
+        fclose(fp);
+    }
+
+    inline void append_pieces(const std::string& filename, std::vector<Piece>& pieces, EdgeList& edges){
+        for(auto& piece : pieces){
+            if(!piece.error.empty())
+                fail(filename, piece.error_reason + " \"" + piece.error + "\"");
+            edges.insert(edges.end(), piece.edges.begin(), piece.edges.end());
+        }
+    }
+
+    // A 1-based id from a file as a node id, or false if it can't be one (checked before
+    // narrowing, so a huge id can't wrap around to a valid-looking node)
+    inline bool to_node_id(uint64_t one_based, uint32_t& id){
+        if(one_based == 0 || one_based - 1 > UINT32_MAX)
+            return false;
+        id = (uint32_t)(one_based - 1);
+        return true;
+    }
+
+    inline void check_edges(const std::string& filename, const EdgeList& edges, size_t num_nodes){
+        for(auto& e : edges){
+            if(e.first >= num_nodes || e.second >= num_nodes)
+                fail(filename, "edge (" + std::to_string(e.first) + ", " + std::to_string(e.second)
+                     + ") refers to a node >= the node count " + std::to_string(num_nodes));
+        }
+    }
+
+    // DIMACS .col: "c" comments, one "p edge N M" line, "e u v" edges (1-based)
+    inline std::shared_ptr<GraphTopology> read_dimacs(const std::string& filename,
+            GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO, size_t num_threads = default_threads()){
+        EdgeList edges;
+        uint64_t num_nodes = 0;
+        bool has_header = false;
+        stream_chunks(filename, [&](const char* begin, const char* end, bool){
+            std::vector<Piece> pieces;
+            parse_pieces(begin, end, num_threads, pieces, [](size_t, const char* b, const char* e, Piece& piece){
+                Cursor c{b, e};
+                while(c.pos < c.end){
+                    c.skip_blanks();
+                    const char* line = c.pos;
+                    if(c.pos < c.end && *c.pos == 'e'){
+                        ++c.pos;
+                        uint64_t u, v;
+                        uint32_t a, b;
+                        if(!c.read_uint(u) || !c.read_uint(v) || !to_node_id(u, a) || !to_node_id(v, b)){
+                            c.pos = line;
+                            piece.error = c.current_line();
+                            return;
+                        }
+                        piece.edges.push_back({a, b});
+                    }
+                    else if(c.pos < c.end && *c.pos == 'p'){
+                        ++c.pos;
+                        c.skip_token(); // "edge" or "col"
+                        if(!c.read_uint(piece.header_nodes) || !c.read_uint(piece.header_edges)){
+                            c.pos = line;
+                            piece.error = c.current_line();
+                            return;
+                        }
+                        piece.has_header = true;
+                    }
+                    c.next_line();
+                }
+            });
+            for(auto& piece : pieces){
+                if(piece.has_header){
+                    num_nodes = piece.header_nodes;
+                    has_header = true;
+                }
+            }
+            append_pieces(filename, pieces, edges);
+        });
+        if(!has_header)
+            fail(filename, "missing \"p edge N M\" line");
+        check_node_count(filename, num_nodes);
+        check_edges(filename, edges, num_nodes);
+        auto topo = std::make_shared<GraphTopology>(num_nodes);
+        topo->build(edges, policy);
+        return topo;
+    }
+
+    // METIS: "%" comments, header "N M [fmt [ncon]]", then one line per node listing its
+    // neighbors (1-based). fmt's last digit means edge weights, the middle one vertex weights.
+    inline std::shared_ptr<GraphTopology> read_metis(const std::string& filename,
+            GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO, size_t num_threads = default_threads()){
+        EdgeList edges;
+        uint64_t num_nodes = 0, num_edges = 0, fmt = 0, ncon = 0;
+        size_t next_node = 0;
+        stream_chunks(filename, [&](const char* begin, const char* end, bool first){
+            if(first){
+                Cursor c{begin, end};
+                while(c.pos < c.end && (*c.pos == '%' || c.at_line_end()))
+                    c.next_line();
+                const char* line = c.pos;
+                if(!c.read_uint(num_nodes) || !c.read_uint(num_edges)){
+                    c.pos = line;
+                    fail(filename, "bad header \"" + c.current_line() + "\"");
+                }
+                if(c.read_uint(fmt) && fmt % 100 / 10 == 1)
+                    ncon = 1;
+                c.read_uint(ncon);
+                c.next_line();
+                begin = c.pos;
+                check_node_count(filename, num_nodes);
+            }
+            bool edge_weights = fmt % 10 == 1;
+            size_t vertex_tokens = (fmt % 100 / 10 == 1 ? ncon : 0) + (fmt / 100 == 1 ? 1 : 0); // Weights, size
+            // Pass 1 counts node lines per piece, so every piece knows its first node
+            std::vector<Piece> counts;
+            parse_pieces(begin, end, num_threads, counts, [](size_t, const char* b, const char* e, Piece& piece){
+                Cursor c{b, e};
+                while(c.pos < c.end){
+                    if(*c.pos != '%')
+                        ++piece.lines;
+                    c.next_line();
+                }
+            });
+            std::vector<size_t> first_node(counts.size());
+            for(size_t i = 0; i < counts.size(); ++i){
+                first_node[i] = next_node;
+                next_node += counts[i].lines;
+            }
+            std::vector<Piece> pieces;
+            parse_pieces(begin, end, num_threads, pieces, [&](size_t index, const char* b, const char* e, Piece& piece){
+                Cursor c{b, e};
+                uint64_t node = first_node[index];
+                while(c.pos < c.end){
+                    if(*c.pos == '%'){
+                        c.next_line();
+                        continue;
+                    }
+                    const char* line = c.pos;
+                    // Blank lines past the last node are trailing whitespace, anything else is extra
+                    if(node >= num_nodes){
+                        if(!c.at_line_end()){
+                            c.pos = line;
+                            piece.error = c.current_line();
+                            piece.error_reason = "more than " + std::to_string(num_nodes) + " node lines at";
+                            return;
+                        }
+                        c.next_line();
+                        continue;
+                    }
+                    for(size_t i = 0; i < vertex_tokens; ++i)
+                        c.skip_token();
+                    uint64_t v;
+                    uint32_t neighbor;
+                    while(!c.at_line_end()){
+                        if(!c.read_uint(v) || !to_node_id(v, neighbor) || (edge_weights && !c.skip_token())){
+                            c.pos = line;
+                            piece.error = c.current_line();
+                            return;
+                        }
+                        // Each edge is listed by both endpoints; keep one copy
+                        if(node < neighbor)
+                            piece.edges.push_back({(uint32_t)node, neighbor});
+                    }
+                    ++node;
+                    c.next_line();
+                }
+            });
+            append_pieces(filename, pieces, edges);
+        });
+        if(next_node < num_nodes)
+            fail(filename, "expected " + std::to_string(num_nodes) + " node lines, found " + std::to_string(next_node));
+        check_edges(filename, edges, num_nodes);
+        auto topo = std::make_shared<GraphTopology>(num_nodes);
+        topo->build(edges, policy);
+        return topo;
+    }
+
+    // Matrix Market: "%%MatrixMarket matrix coordinate ..." banner, "%" comments, a
+    // "rows cols entries" line, then "i j [value]" entries (1-based). Every off-diagonal
+    // entry becomes an undirected edge.
+    inline std::shared_ptr<GraphTopology> read_matrix_market(const std::string& filename,
+            GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO, size_t num_threads = default_threads()){
+        EdgeList edges;
+        uint64_t rows = 0, cols = 0, entries = 0;
+        stream_chunks(filename, [&](const char* begin, const char* end, bool first){
+            if(first){
+                Cursor c{begin, end};
+                std::string banner = c.current_line();
+                if(banner.compare(0, 14, "%%MatrixMarket") != 0 || banner.find("coordinate") == std::string::npos)
+                    fail(filename, "expected a \"%%MatrixMarket matrix coordinate\" banner");
+                while(c.pos < c.end && (*c.pos == '%' || c.at_line_end()))
+                    c.next_line();
+                const char* line = c.pos;
+                if(!c.read_uint(rows) || !c.read_uint(cols) || !c.read_uint(entries)){
+                    c.pos = line;
+                    fail(filename, "bad size line \"" + c.current_line() + "\"");
+                }
+                c.next_line();
+                begin = c.pos;
+            }
+            std::vector<Piece> pieces;
+            parse_pieces(begin, end, num_threads, pieces, [](size_t, const char* b, const char* e, Piece& piece){
+                Cursor c{b, e};
+                while(c.pos < c.end){
+                    if(*c.pos == '%' || c.at_line_end()){
+                        c.next_line();
+                        continue;
+                    }
+                    const char* line = c.pos;
+                    uint64_t i, j;
+                    uint32_t a, b;
+                    if(!c.read_uint(i) || !c.read_uint(j) || !to_node_id(i, a) || !to_node_id(j, b)){
+                        c.pos = line;
+                        piece.error = c.current_line();
+                        return;
+                    }
+                    if(a != b)
+                        piece.edges.push_back({a, b});
+                    c.next_line();
+                }
+            });
+            append_pieces(filename, pieces, edges);
+        });
+        uint64_t num_nodes = std::max(rows, cols);
+        check_node_count(filename, num_nodes);
+        check_edges(filename, edges, num_nodes);
+        auto topo = std::make_shared<GraphTopology>(num_nodes);
+        topo->build(edges, policy);
+        return topo;
+    }
+
+    // The original format: "N M", then M lines of "a b" (0-based). As before, edge_count
+    // is taken from the header rather than counted.
+    inline std::shared_ptr<GraphTopology> read_edge_list(const std::string& filename,
+            GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO){
+        std::ifstream fp;
+        fp.open(filename, std::ios::in | std::ios::ate);
+        if(!fp.is_open())
+            fail(filename, "could not open file");
+        uint64_t file_size = fp.tellg();
+        fp.seekg(0);
+        size_t num_nodes, num_edges;
+        if(!(fp >> num_nodes >> num_edges))
+            fail(filename, "missing \"N M\" header");
+        check_node_count(filename, num_nodes);
+        // Every edge takes at least 4 bytes (a separator and "a b"), so a corrupt header
+        // is caught here instead of by allocating for it
+        if(num_edges > file_size / 4)
+            fail(filename, "header claims " + std::to_string(num_edges) + " edges, more than the file can hold");
+        EdgeList edges;
+        edges.reserve(std::min(num_edges, (size_t)1 << 20));
+        size_t a, b;
+        for(size_t i = 0; i < num_edges; ++i){
+            if(!(fp >> a >> b))
+                fail(filename, "expected " + std::to_string(num_edges) + " edges, found " + std::to_string(i));
+            // Checked before narrowing, so a huge id can't wrap around to a valid-looking node
+            if(a >= num_nodes || b >= num_nodes)
+                fail(filename, "edge (" + std::to_string(a) + ", " + std::to_string(b)
+                     + ") refers to a node >= the node count " + std::to_string(num_nodes));
+            edges.push_back({(uint32_t)a, (uint32_t)b});
+        }
+        fp.close();
+        auto topo = std::make_shared<GraphTopology>(num_nodes);
+        topo->build(edges, policy);
+        topo->edge_count = num_edges;
+        return topo;
+    }
+
+    // Picks the reader from the file's contents (binary) or extension (text formats)
+    inline std::shared_ptr<GraphTopology> load(const std::string& filename,
+            GraphTopology::BitsetPolicy policy = GraphTopology::BITSET_AUTO){
+        if(is_binary(filename))
+            return map_binary(filename, policy);
+        if(ends_with(filename, ".col"))
+            return read_dimacs(filename, policy);
+        if(ends_with(filename, ".graph") || ends_with(filename, ".metis"))
+            return read_metis(filename, policy);
+        if(ends_with(filename, ".mtx"))
+            return read_matrix_market(filename, policy);
+        return read_edge_list(filename, policy);
+    }
+}
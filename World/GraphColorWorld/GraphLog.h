@@ -0,0 +1,252 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+// Local includes
+#include "./GraphTopology.h"
+#include "./GraphIO.h"
+#include "./GraphChurn.h"
+
+// Records the graph each generation was evaluated on.
+//
+// Entries are handed to a background writer thread, which formats and writes them, so
+// logging never happens on the evaluation thread. Topologies are immutable and shared,
+// so queueing one costs a pointer, not a copy. The queue is bounded by the memory held
+// by the pending topologies; if the writer falls that far behind, new entries are dropped
+// (and counted) rather than stalling evaluation.
+//
+// Formats:
+//      matrix  graph.csv in the original format, with a dense N x N adjacency matrix (the default)
+//      edges   graph.csv, one row per generation with an edge list
+//      binary  graph.gcg, one GraphIO binary image per generation, back to back
+//      seed    graph.csv with only the generator, its parameters and seed (graphs can be
+//              regenerated with GraphGenerators::generate); needs a non-legacy generator
+//      none    nothing is written
+//
+// Generations of a dynamic graph are logged as their diff from the previous generation,
+// to graph_diff.csv next to the log, whatever the format.
+class GraphLog{
+public:
+    enum Format{
+        NONE,
+        EDGES,
+        MATRIX,
+        BINARY,
+        SEED
+    };
+
+    struct Entry{
+        size_t generation = 0;
+        std::shared_ptr<const GraphTopology> topology;
+        std::string generator;      // GraphGenerators::type_to_string, or "file:<path>"
+        size_t num_nodes = 0;
+        double edge_chance = 0, power_law_exponent = 0;
+        uint64_t seed = 0;
+        std::shared_ptr<const GraphChurn::Diff> diff;  // Set for a dynamic graph's later generations
+    };
+
+    static Format format_from_string(const std::string& name){
+        if(name == "none")
+            return NONE;
+        if(name == "edges")
+            return EDGES;
+        if(name == "matrix")
+            return MATRIX;
+        if(name == "binary")
+            return BINARY;
+        if(name == "seed")
+            return SEED;
+        std::cout << "Unknown graph log format \"" << name << "\" (expected edges, matrix, "
+                  << "binary, seed or none)" << std::endl;
+        exit(-1);
+    }
+
+    Format format = NONE;
+    std::string path;
+
+    ~GraphLog(){
+        close();
+    }
+
+    void open(const std::string& dir, Format format_, size_t max_pending_bytes_){
+        close();
+        format = format_;
+        max_pending_bytes = max_pending_bytes_;
+        if(format == NONE)
+            return;
+        diff_path = dir + "/graph_diff.csv";
+        path = dir + (format == BINARY ? "/graph.gcg" : "/graph.csv");
+        file.open(path, format == BINARY ? std::ios::out | std::ios::binary : std::ios::out);
+        if(!file.is_open()){
+            std::cout << "Error! Could not open " << path << " for writing" << std::endl;
+            exit(-1);
+        }
+        if(format == EDGES)
+            file << "generation,node_count,edge_count,edges" << std::endl;
+        else if(format == MATRIX)
+            file << "node_count,edge_count,adj_vec" << std::endl;
+        else if(format == SEED)
+            file << "generation,generator,node_count,edge_chance,power_law_exponent,seed" << std::endl;
+        shutting_down = false;
+        writer = std::thread(&GraphLog::writer_loop, this);
+    }
+
+    // Queues an entry and returns immediately
+    void log(Entry entry){
+        if(format == NONE)
+            return;
+        if(format == SEED || entry.diff)
+            entry.topology = nullptr; // Don't keep the graph alive for nothing
+        size_t bytes = entry_bytes(entry);
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            // Always accept one entry, however big, so huge graphs are still logged
+            if(!pending.empty() && pending_bytes + bytes > max_pending_bytes){
+                if(dropped++ == 0)
+                    std::cout << "Warning: graph log writer is falling behind; dropping graphs "
+                              << "(raise graphLogBufferMB to keep them)" << std::endl;
+                return;
+            }
+            pending_bytes += bytes;
+            pending.push_back(std::move(entry));
+        }
+        queue_cv.notify_one();
+    }
+
+    // Stops the writer after the entry it is writing, if any, leaving the rest queued, so
+    // the process can fork with no other thread running; resume() picks up from there
+    void pause(){
+        if(!writer.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            pausing = true;
+        }
+        queue_cv.notify_one();
+        writer.join();
+        paused = true;
+    }
+
+    void resume(){
+        if(!paused)
+            return;
+        paused = false;
+        pausing = false;
+        writer = std::thread(&GraphLog::writer_loop, this);
+    }
+
+    // Writes everything still queued, then stops the writer
+    void close(){
+        resume();
+        if(!writer.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            shutting_down = true;
+        }
+        queue_cv.notify_one();
+        writer.join();
+        file.close();
+        diff_file.close();
+        if(dropped > 0)
+            std::cout << "graph log: " << dropped << " graphs were dropped because the writer fell behind" << std::endl;
+    }
+
+    size_t dropped_count(){
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        return dropped;
+    }
+
+private:
+    std::ofstream file;
+    std::ofstream diff_file;    // Opened by the writer at the first diff
+    std::string diff_path;
+    std::thread writer;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Entry> pending;
+    size_t pending_bytes = 0, max_pending_bytes = 0, dropped = 0;
+    bool shutting_down = false;
+    bool pausing = false, paused = false;
+
+    static size_t entry_bytes(const Entry& entry){
+        return sizeof(Entry) + (entry.topology ? entry.topology->memory_usage() : 0)
+            + (entry.diff ? entry.diff->memory_usage() : 0);
+    }
+
+    void write_diff(const Entry& entry){
+        if(!diff_file.is_open()){
+            diff_file.open(diff_path);
+            if(!diff_file.is_open()){
+                std::cout << "Error! Could not open " << diff_path << " for writing" << std::endl;
+                exit(-1);
+            }
+            diff_file << "generation,seed,replaced_nodes,removed,added" << std::endl;
+        }
+        diff_file << entry.generation << "," << entry.seed << "," << entry.diff->replaced_nodes.size()
+                  << ",\"" << GraphChurn::to_edge_list_string(entry.diff->removed)
+                  << "\",\"" << GraphChurn::to_edge_list_string(entry.diff->added) << "\"\n";
+    }
+
+    void write(const Entry& entry){
+        if(entry.diff){
+            write_diff(entry);
+            return;
+        }
+        switch(format){
+            case EDGES:
+                file << entry.generation << "," << entry.topology->node_count << "," << entry.topology->edge_count
+                     << ",\"" << GraphIO::to_edge_list_string(*entry.topology) << "\"\n";
+                break;
+            case MATRIX:
+                file << GraphIO::to_matrix_csv(*entry.topology) << "\n";
+                break;
+            case BINARY:
+                GraphIO::write_binary(*entry.topology, file);
+                break;
+            case SEED:
+                // Full precision, so the exact edge chance can be fed back to the generator
+                file << std::setprecision(17) << entry.generation << "," << entry.generator << "," 
+                     << entry.num_nodes << "," << entry.edge_chance << "," << entry.power_law_exponent 
+                     << "," << entry.seed << "\n";
+                break;
+            default:
+                break;
+        }
+    }
+
+    void writer_loop(){
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        while(true){
+            queue_cv.wait(lock, [this]{ return shutting_down || pausing || !pending.empty(); });
+            if(pausing)
+                return;
+            if(pending.empty()){
+                file.flush();
+                diff_file.flush();
+                return;
+            }
+            Entry entry = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+            write(entry);
+            lock.lock();
+            pending_bytes -= entry_bytes(entry);
+            // Flush whenever the writer catches up, so the file is current between generations
+            if(pending.empty()){
+                lock.unlock();
+                file.flush();
+                diff_file.flush();
+                lock.lock();
+            }
+        }
+    }
+};
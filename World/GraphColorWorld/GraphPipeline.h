@@ -0,0 +1,106 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+// Local includes
+#include "./GraphLog.h"
+
+// Builds the graphs of upcoming generations on a background thread while the current
+// generation is evaluated, so generating (and analyzing) a large graph is off the
+// critical path. Graphs are produced in generation order into a buffer of up to depth
+// graphs and taken by the world at the start of each generation; depth 1 is a double
+// buffer (the graph in use, and the next one ready or being built).
+//
+// The producer runs concurrently with evaluation, so it must not touch MABE's shared
+// generator or anything the world mutates.
+class GraphPipeline{
+public:
+    struct Graph{
+        GraphLog::Entry entry;
+        size_t best_colors = 0;     // For normalizeGraphScore (0 = not computed)
+    };
+    using Producer = std::function<Graph(size_t generation)>;
+
+    ~GraphPipeline(){
+        stop();
+    }
+
+    bool running() const{
+        return producer.joinable();
+    }
+
+    // Starts producing the graphs of generations first_generation, first_generation + 1, ...
+    void start(size_t depth_, size_t first_generation, Producer produce_){
+        stop();
+        depth = depth_ < 1 ? 1 : depth_;
+        produce = produce_;
+        next_generation = first_generation;
+        shutting_down = false;
+        producer = std::thread(&GraphPipeline::producer_loop, this);
+    }
+
+    // The graph of generation, waiting for it if it isn't ready yet. Generations must be
+    // taken in order.
+    Graph take(size_t generation){
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if(ready.empty())
+            ++waits;
+        ++taken;
+        queue_cv.wait(lock, [this]{ return !ready.empty(); });
+        Graph graph = std::move(ready.front());
+        ready.pop_front();
+        lock.unlock();
+        queue_cv.notify_all();
+        if(graph.entry.generation != generation){
+            std::cout << "Graph pipeline produced the graph of generation " << graph.entry.generation
+                      << " for generation " << generation << std::endl;
+            exit(-1);
+        }
+        return graph;
+    }
+
+    // Stops producing; a graph being built is finished and dropped
+    void stop(){
+        if(!producer.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            shutting_down = true;
+        }
+        queue_cv.notify_all();
+        producer.join();
+        ready.clear();
+        if(taken > 0)
+            std::cout << "graph pipeline: " << waits << " of " << taken
+                      << " generations waited for their graph" << std::endl;
+    }
+
+private:
+    std::thread producer;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Graph> ready;
+    Producer produce;
+    size_t depth = 2, next_generation = 0, waits = 0, taken = 0;
+    bool shutting_down = false;
+
+    void producer_loop(){
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [this]{ return shutting_down || ready.size() < depth; });
+                if(shutting_down)
+                    return;
+            }
+            Graph graph = produce(next_generation++);
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                ready.push_back(std::move(graph));
+            }
+            queue_cv.notify_all();
+        }
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+// MABE includes
+#include "../../Utilities/Random.h"
+// Local includes
+#include "./GraphTopology.h"
+#include "./GraphAnalysis.h"
+#include "./ColoringEngines.h"
+
+// A fixed set of graphs, built (generated or loaded) once at startup, that generations
+// draw from instead of building a new graph each time. Each graph's metadata is
+// computed when it is added, so analysis is paid once per run as well.
+class GraphPool{
+public:
+    enum Order{
+        RANDOM,     // A random pool graph per step
+        CYCLE,      // Pool graphs in the order they were added, wrapping around
+        CURRICULUM  // Like CYCLE, but easiest first (fewest DSatur colors, then smallest)
+    };
+
+    struct Entry{
+        std::shared_ptr<const GraphTopology> topology;
+        std::string source;         // Generator name or file the graph came from
+        size_t max_degree = 0;
+        size_t degeneracy = 0;
+        size_t greedy_colors = 0;   // Colors used by greedy coloring in node order
+        size_t dsatur_colors = 0;   // Colors used by DSatur
+        size_t exact_colors = 0;    // Colors used by the bounded exact search (0 if it was skipped)
+        bool optimal = false;       // exact_colors is the chromatic number
+
+        // Fewest colors a known coloring of this graph uses
+        size_t best_colors() const{
+            size_t best = std::min(greedy_colors, dsatur_colors);
+            return exact_colors > 0 ? std::min(best, exact_colors) : best;
+        }
+    };
+
+    std::vector<Entry> entries;
+    Order order = RANDOM;
+    size_t exact_search_nodes = 0;      // Budget for ColoringEngines::exact on each graph (0 = skip it)
+    size_t generations_per_graph = 1;   // Generations spent on a graph before moving to the next
+
+    static Order order_from_string(const std::string& name){
+        if(name == "random")
+            return RANDOM;
+        if(name == "cycle")
+            return CYCLE;
+        if(name == "curriculum")
+            return CURRICULUM;
+        std::cout << "Unknown graph pool order \"" << name << "\" (expected random, cycle or curriculum)"
+                  << std::endl;
+        exit(-1);
+    }
+
+    static Entry describe(std::shared_ptr<const GraphTopology> topology, const std::string& source,
+                          size_t exact_search_nodes = 0){
+        Entry entry;
+        entry.topology = topology;
+        entry.source = source;
+        entry.max_degree = topology->max_degree;
+        entry.degeneracy = GraphAnalysis::degeneracy(*topology);
+        entry.greedy_colors = GraphAnalysis::count_colors(GraphAnalysis::greedy_coloring(*topology));
+        entry.dsatur_colors = GraphAnalysis::count_colors(GraphAnalysis::dsatur_coloring(*topology));
+        if(exact_search_nodes > 0){
+            ColoringEngines::Result exact = ColoringEngines::exact(*topology, exact_search_nodes);
+            entry.exact_colors = exact.num_colors;
+            entry.optimal = exact.optimal;
+        }
+        return entry;
+    }
+
+    void add(std::shared_ptr<const GraphTopology> topology, const std::string& source){
+        entries.push_back(describe(topology, source, exact_search_nodes));
+    }
+
+    bool empty() const{
+        return entries.empty();
+    }
+
+    size_t max_node_count() const{
+        size_t result = 0;
+        for(auto& entry : entries)
+            result = std::max(result, entry.topology->node_count);
+        return result;
+    }
+
+    // Call once every graph has been added
+    void finalize(){
+        if(order == CURRICULUM){
+            std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){
+                if(a.dsatur_colors != b.dsatur_colors)
+                    return a.dsatur_colors < b.dsatur_colors;
+                if(a.topology->node_count != b.topology->node_count)
+                    return a.topology->node_count < b.topology->node_count;
+                return a.topology->edge_count < b.topology->edge_count;
+            });
+        }
+    }
+
+    // The graph to evaluate on in the given generation. Call once per generation, in order:
+    // RANDOM draws from MABE's generator whenever it moves to a new graph.
+    const Entry& pick(size_t generation){
+        size_t step = generation / std::max((size_t)1, generations_per_graph);
+        if(order != RANDOM)
+            return entries[step % entries.size()];
+        if(current >= entries.size() || step != current_step){
+            current = Random::getIndex(entries.size());
+            current_step = step;
+        }
+        return entries[current];
+    }
+
+    void print_summary(std::ostream& out) const{
+        size_t min_nodes = (size_t)-1, max_nodes = 0, min_colors = (size_t)-1, max_colors = 0, optimal = 0;
+        for(auto& entry : entries){
+            optimal += entry.optimal;
+            min_nodes = std::min(min_nodes, entry.topology->node_count);
+            max_nodes = std::max(max_nodes, entry.topology->node_count);
+            min_colors = std::min(min_colors, entry.best_colors());
+            max_colors = std::max(max_colors, entry.best_colors());
+        }
+        out << "Graph pool: " << entries.size() << " graphs, " << min_nodes << "-" << max_nodes
+            << " nodes, best known colorings use " << min_colors << "-" << max_colors << " colors ("
+            << optimal << " proven optimal)" << std::endl;
+    }
+
+private:
+    size_t current = (size_t)-1;
+    size_t current_step = 0;
+};
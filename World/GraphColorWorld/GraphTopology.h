@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// The structure of a graph (no colors). Once built, a topology is only changed by patch,
+// and only while nothing else holds it, so it can be shared read-only between every
+// Graph that evaluates on it.
+//
+// Adjacency is stored in compressed sparse row (CSR) form: the neighbors of node n
+// are neighbors[offsets[n]] ... neighbors[offsets[n + 1] - 1], sorted ascending.
+// Dense graphs can also carry a bit matrix so neighbor tests are a single bit lookup.
+//
+// The CSR arrays are read through row_offsets/row_ends/row_neighbors, which point either
+// into the vectors below (after build) or into memory owned by someone else, such as a
+// memory-mapped graph file (see GraphIO::map_binary and attach). Row n ends at
+// row_ends[n], which is row_offsets + 1 while the rows are packed; once patched, rows
+// have room to grow and a row that outgrows it is moved to the end of neighbors.
+class GraphTopology{
+public:
+    enum BitsetPolicy{
+        BITSET_AUTO = -1,   // Build the bit matrix when it is no bigger than the neighbor array
+        BITSET_NEVER = 0,
+        BITSET_ALWAYS = 1
+    };
+
+    size_t node_count, edge_count, max_degree;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> neighbors;
+    std::vector<uint64_t> adj_bits; // Empty unless the bit matrix was built
+    size_t words_per_row;
+    const uint64_t* row_offsets;
+    const uint64_t* row_ends;
+    const uint32_t* row_neighbors;
+    std::shared_ptr<const void> external_storage; // Keeps attached arrays alive
+
+    // Only kept once the rows are patched
+    std::vector<uint64_t> ends;
+    std::vector<uint64_t> row_capacity;
+    std::vector<uint64_t> degree_tree;  // Fenwick tree of the degrees, to find the row of a directed entry
+    std::vector<size_t> degree_counts;  // Nodes of each degree, so max_degree follows the patches
+
+    GraphTopology(size_t num_nodes = 0){
+        node_count = num_nodes;
+        edge_count = 0;
+        max_degree = 0;
+        words_per_row = 0;
+        offsets.assign(node_count + 1, 0);
+        set_rows(offsets.data(), neighbors.data());
+    }
+
+    // The row pointers would dangle in a copy
+    GraphTopology(const GraphTopology&) = delete;
+    GraphTopology& operator=(const GraphTopology&) = delete;
+
+    // Builds the CSR arrays from an undirected edge list. Duplicate edges are dropped,
+    // and edge_count is the number of distinct edges.
+    void build(std::vector<std::pair<uint32_t, uint32_t>>& edges, BitsetPolicy policy = BITSET_AUTO){
+        // Each undirected edge is stored in both directions
+        size_t num_directed = 0;
+        offsets.assign(node_count + 1, 0);
+        for(auto& e : edges){
+            ++offsets[e.first + 1];
+            if(e.first != e.second)
+                ++offsets[e.second + 1];
+        }
+        for(size_t n = 0; n < node_count; ++n)
+            offsets[n + 1] += offsets[n];
+        num_directed = offsets[node_count];
+        neighbors.resize(num_directed);
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for(auto& e : edges){
+            neighbors[fill[e.first]++] = e.second;
+            if(e.first != e.second)
+                neighbors[fill[e.second]++] = e.first;
+        }
+        // Sort and dedup each row, compacting the array as we go
+        size_t write = 0, self_loops = 0;
+        for(size_t n = 0; n < node_count; ++n){
+            auto row_begin = neighbors.begin() + offsets[n];
+            auto row_end = neighbors.begin() + offsets[n + 1];
+            std::sort(row_begin, row_end);
+            row_end = std::unique(row_begin, row_end);
+            offsets[n] = write;
+            for(auto I = row_begin; I != row_end; ++I){
+                if(*I == n)
+                    ++self_loops;
+                neighbors[write++] = *I;
+            }
+        }
+        offsets[node_count] = write;
+        neighbors.resize(write);
+        neighbors.shrink_to_fit();
+        set_rows(offsets.data(), neighbors.data());
+        external_storage = nullptr;
+        edge_count = (write - self_loops) / 2 + self_loops;
+        max_degree = get_max_degree();
+
+        adj_bits.clear();
+        words_per_row = 0;
+        apply_bitset_policy(policy);
+    }
+
+    // Uses CSR arrays owned elsewhere (already sorted and deduplicated) without copying them.
+    // storage is held for as long as this topology lives.
+    void attach(const uint64_t* offsets_, const uint32_t* neighbors_, size_t num_edges,
+                std::shared_ptr<const void> storage, BitsetPolicy policy = BITSET_AUTO){
+        offsets.clear();
+        offsets.shrink_to_fit();
+        neighbors.clear();
+        neighbors.shrink_to_fit();
+        set_rows(offsets_, neighbors_);
+        external_storage = storage;
+        edge_count = num_edges;
+        max_degree = get_max_degree();
+        apply_bitset_policy(policy);
+    }
+
+    // Takes over CSR arrays that are already sorted and deduplicated
+    void assign(std::vector<uint64_t>&& offsets_, std::vector<uint32_t>&& neighbors_, size_t num_edges,
+                BitsetPolicy policy = BITSET_AUTO){
+        offsets = std::move(offsets_);
+        neighbors = std::move(neighbors_);
+        set_rows(offsets.data(), neighbors.data());
+        external_storage = nullptr;
+        edge_count = num_edges;
+        max_degree = get_max_degree();
+        apply_bitset_policy(policy);
+    }
+
+    size_t num_directed_edges() const{
+        return num_directed;
+    }
+
+    bool patched() const{
+        return !ends.empty();
+    }
+
+    bool wants_bitset(BitsetPolicy policy) const{
+        return policy == BITSET_ALWAYS || (policy == BITSET_AUTO &&
+            node_count * ((node_count + 63) / 64) * sizeof(uint64_t) <= num_directed_edges() * sizeof(uint32_t));
+    }
+
+    void apply_bitset_policy(BitsetPolicy policy){
+        adj_bits.clear();
+        words_per_row = 0;
+        if(wants_bitset(policy))
+            build_bitset();
+    }
+
+    void build_bitset(){
+        words_per_row = (node_count + 63) / 64;
+        adj_bits.assign(node_count * words_per_row, 0);
+        for(size_t n = 0; n < node_count; ++n){
+            for(const uint32_t* m = neighbors_begin(n); m != neighbors_end(n); ++m)
+                flip_bit(n, *m);
+        }
+    }
+
+    size_t degree(size_t n) const{
+        return row_ends[n] - row_offsets[n];
+    }
+
+    const uint32_t* neighbors_begin(size_t n) const{
+        return row_neighbors + row_offsets[n];
+    }
+
+    const uint32_t* neighbors_end(size_t n) const{
+        return row_neighbors + row_ends[n];
+    }
+
+    // The directed edge (a, b) at index entry of the packed neighbor array, i.e. b is
+    // a's (entry - edges of nodes before a)th neighbor; entries index every edge once
+    // per direction, so a random entry is a uniformly random edge
+    std::pair<uint32_t, uint32_t> directed_entry(size_t entry) const{
+        size_t node = 0;
+        if(!patched()){
+            node = std::upper_bound(row_offsets, row_offsets + node_count + 1, (uint64_t)entry) - row_offsets - 1;
+            return std::make_pair((uint32_t)node, row_neighbors[entry]);
+        }
+        // Descend the tree to the last node whose preceding rows hold at most entry edges
+        size_t step = 1;
+        while(step * 2 <= node_count)
+            step *= 2;
+        for(; step > 0; step /= 2){
+            if(node + step <= node_count && degree_tree[node + step] <= entry){
+                node += step;
+                entry -= degree_tree[node];
+            }
+        }
+        return std::make_pair((uint32_t)node, neighbors_begin(node)[entry]);
+    }
+
+    size_t get_max_degree() const{
+        size_t cur_max = 0;
+        for(size_t n = 0; n < node_count; ++n){
+            if(degree(n) > cur_max)
+                cur_max = degree(n);
+        }
+        return cur_max;
+    }
+
+    bool check_neighbors(size_t a, size_t b) const{
+        if(!adj_bits.empty())
+            return (adj_bits[a * words_per_row + (b >> 6)] >> (b & 63)) & 1;
+        // Rows are symmetric, so search whichever one is shorter
+        if(degree(b) < degree(a))
+            std::swap(a, b);
+        return std::binary_search(neighbors_begin(a), neighbors_end(a), (uint32_t)b);
+    }
+
+    // Removes and adds directed entries in place; both lists are sorted by (row, neighbor),
+    // every removed entry is in a row and no added one is. Only the changed rows are
+    // rewritten, and degrees, max_degree and the bit matrix are updated from them; the
+    // first patch unpacks the rows in O(N + E), after that the cost is in the changes.
+    // Only for a topology nothing else shares, as every reader sees the change.
+    void patch(const std::vector<std::pair<uint32_t, uint32_t>>& removed,
+               const std::vector<std::pair<uint32_t, uint32_t>>& added, size_t num_edges,
+               BitsetPolicy policy = BITSET_AUTO){
+        if(!patched())
+            unpack();
+        std::vector<uint32_t> row;
+        size_t r = 0, a = 0;
+        while(r < removed.size() || a < added.size()){
+            uint32_t node = a == added.size() || (r < removed.size() && removed[r].first < added[a].first)
+                ? removed[r].first : added[a].first;
+            // Merge the row with its sorted changes, as GraphChurn::apply does
+            row.clear();
+            for(const uint32_t* n = neighbors_begin(node); n != neighbors_end(node); ++n){
+                if(r < removed.size() && removed[r].first == node && removed[r].second == *n){
+                    ++r;
+                    continue;
+                }
+                while(a < added.size() && added[a].first == node && added[a].second < *n)
+                    row.push_back(added[a++].second);
+                row.push_back(*n);
+            }
+            while(a < added.size() && added[a].first == node)
+                row.push_back(added[a++].second);
+            store_row(node, row);
+        }
+        num_directed = num_directed + added.size() - removed.size();
+        edge_count = num_edges;
+        while(max_degree > 0 && degree_counts[max_degree] == 0)
+            --max_degree;
+        // Rows that moved left their old room behind; repack once it is most of the array
+        if(neighbors.size() > 2 * num_directed + node_count)
+            compact();
+
+        if(!adj_bits.empty() && wants_bitset(policy)){
+            for(const auto* changes : {&removed, &added}){
+                for(auto& entry : *changes)
+                    flip_bit(entry.first, entry.second);
+            }
+        }
+        else if(!adj_bits.empty() || wants_bitset(policy))
+            apply_bitset_policy(policy);
+    }
+
+    // Bytes held by the adjacency structure (attached arrays count too, even if mapped)
+    size_t memory_usage() const{
+        if(patched())
+            return (offsets.capacity() + ends.capacity() + row_capacity.capacity() + degree_tree.capacity()) * sizeof(uint64_t)
+                + neighbors.capacity() * sizeof(uint32_t) + degree_counts.capacity() * sizeof(size_t)
+                + adj_bits.capacity() * sizeof(uint64_t);
+        return (node_count + 1) * sizeof(uint64_t) + num_directed_edges() * sizeof(uint32_t)
+            + adj_bits.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    size_t num_directed = 0;
+
+    // Packed rows: row n ends where row n + 1 starts
+    void set_rows(const uint64_t* offsets_, const uint32_t* neighbors_){
+        row_offsets = offsets_;
+        row_ends = offsets_ + 1;
+        row_neighbors = neighbors_;
+        num_directed = row_offsets[node_count];
+        ends.clear();
+        ends.shrink_to_fit();
+        row_capacity.clear();
+        row_capacity.shrink_to_fit();
+        degree_tree.clear();
+        degree_tree.shrink_to_fit();
+        degree_counts.clear();
+        degree_counts.shrink_to_fit();
+    }
+
+    void flip_bit(size_t a, uint32_t b){
+        adj_bits[a * words_per_row + (b >> 6)] ^= (uint64_t)1 << (b & 63);
+    }
+
+    // Copies attached rows into this topology's own arrays, and sets up what patch keeps
+    void unpack(){
+        if(row_offsets != offsets.data()){
+            offsets.assign(row_offsets, row_offsets + node_count + 1);
+            neighbors.assign(row_neighbors, row_neighbors + num_directed);
+            external_storage = nullptr;
+        }
+        ends.assign(offsets.begin() + 1, offsets.end());
+        row_capacity.resize(node_count);
+        degree_tree.assign(node_count + 1, 0);
+        degree_counts.assign(max_degree + 1, 0);
+        for(size_t n = 0; n < node_count; ++n){
+            row_capacity[n] = ends[n] - offsets[n];
+            degree_tree[n + 1] += row_capacity[n];
+            // Each entry also belongs to the parent range that covers it
+            size_t parent = (n + 1) + ((n + 1) & (~(n + 1) + 1));
+            if(parent <= node_count)
+                degree_tree[parent] += degree_tree[n + 1];
+            ++degree_counts[row_capacity[n]];
+        }
+        row_offsets = offsets.data();
+        row_ends = ends.data();
+        row_neighbors = neighbors.data();
+    }
+
+    // Writes node's new row, moving it to the end of neighbors if it doesn't fit
+    void store_row(uint32_t node, const std::vector<uint32_t>& row){
+        size_t old_degree = degree(node);
+        if(row.size() > row_capacity[node]){
+            // Room for half as many again, so a row that keeps growing moves rarely
+            row_capacity[node] = row.size() + row.size() / 2;
+            offsets[node] = neighbors.size();
+            neighbors.resize(neighbors.size() + row_capacity[node]);
+            row_neighbors = neighbors.data();
+        }
+        std::copy(row.begin(), row.end(), neighbors.begin() + offsets[node]);
+        ends[node] = offsets[node] + row.size();
+
+        for(size_t i = (size_t)node + 1; i <= node_count; i += i & (~i + 1))
+            degree_tree[i] += row.size() - old_degree;
+        --degree_counts[old_degree];
+        if(row.size() >= degree_counts.size())
+            degree_counts.resize(row.size() + 1, 0);
+        ++degree_counts[row.size()];
+        max_degree = std::max(max_degree, row.size());
+    }
+
+    // Moves every row back to the front of neighbors with no room to spare
+    void compact(){
+        std::vector<uint32_t> packed(num_directed);
+        size_t write = 0;
+        for(size_t n = 0; n < node_count; ++n){
+            size_t row_begin = write;
+            write = std::copy(neighbors_begin(n), neighbors_end(n), packed.begin() + write) - packed.begin();
+            offsets[n] = row_begin;
+            ends[n] = write;
+            row_capacity[n] = write - row_begin;
+        }
+        offsets[node_count] = write;
+        neighbors.swap(packed);
+        row_neighbors = neighbors.data();
+    }
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A message between nodes: who sent it and the sender's color bits when it was sent
+struct NodeMessage{
+    uint32_t sender;
+    uint32_t color_bits;
+};
+
+// Every node's inbox, as a ring buffer carved out of one shared arena.
+//
+// The arena is kept between evaluations, so once it has grown to fit, evaluations
+// allocate nothing. With a capacity, each inbox holds at most that many messages and
+// the overflow policy decides which message is lost. With capacity 0 (unbounded), a
+// full inbox moves to a fresh region of the arena twice its size; the region it leaves
+// is only reclaimed by the next reset. An inbox only grows when full, so its regions add
+// up to less than 4 times the most messages it held. An unbounded evaluation therefore
+// uses under 4 * (nodes + messages sent) arena entries of 8 bytes, and the arena doubles
+// when it grows, so it allocates at most twice that. As a node sends at most one message
+// per tick, the worst case is 64 * nodes * (lifetime + 1) bytes.
+class MessageQueues{
+public:
+    enum OverflowPolicy{
+        DROP_NEWEST,    // The incoming message is discarded
+        DROP_OLDEST     // The oldest queued message is discarded to make room
+    };
+
+    struct Stats{
+        size_t pushed = 0;      // Messages sent to an inbox, including ones that were dropped
+        size_t popped = 0;
+        size_t dropped = 0;
+        size_t high_water = 0;  // Longest any inbox has been
+
+        void merge(const Stats& other){
+            pushed += other.pushed;
+            popped += other.popped;
+            dropped += other.dropped;
+            high_water = std::max(high_water, other.high_water);
+        }
+
+        std::string to_string() const{
+            std::ostringstream oss;
+            oss << "message queues: " << pushed << " sent, " << popped << " delivered, "
+                << dropped << " dropped; longest inbox held " << high_water;
+            return oss.str();
+        }
+    };
+
+    Stats stats;        // Since the last reset
+    Stats total_stats;  // Over every evaluation
+
+    // Empties every inbox for an evaluation on num_nodes nodes
+    void reset(size_t num_nodes, size_t capacity_, OverflowPolicy policy_){
+        total_stats.merge(stats);
+        stats = Stats();
+        capacity = capacity_;
+        policy = policy_;
+        size_t initial = capacity > 0 ? capacity : (size_t)initial_unbounded_capacity;
+        if(initial > max_ring_capacity){
+            std::cout << "Message queue capacity " << capacity << " is more than an inbox can hold ("
+                      << max_ring_capacity << ")" << std::endl;
+            exit(-1);
+        }
+        rings.resize(num_nodes);
+        for(size_t n = 0; n < num_nodes; ++n)
+            rings[n] = {n * initial, (uint32_t)initial, 0, 0};
+        arena_used = num_nodes * initial;
+        if(arena.size() < arena_used)
+            arena.resize(arena_used);
+    }
+
+    bool empty(size_t n) const{
+        return rings[n].count == 0;
+    }
+
+    size_t size(size_t n) const{
+        return rings[n].count;
+    }
+
+    void push(size_t n, const NodeMessage& msg){
+        Ring& ring = rings[n];
+        ++stats.pushed;
+        if(ring.count == ring.capacity){
+            if(capacity == 0){
+                grow(ring);
+            }
+            else if(policy == DROP_NEWEST){
+                ++stats.dropped;
+                return;
+            }
+            else{
+                ++stats.dropped;
+                ring.head = next(ring, ring.head);
+                --ring.count;
+            }
+        }
+        uint32_t tail = ring.head + ring.count;
+        if(tail >= ring.capacity)
+            tail -= ring.capacity;
+        arena[ring.start + tail] = msg;
+        ++ring.count;
+        if(ring.count > stats.high_water)
+            stats.high_water = ring.count;
+    }
+
+    // The inbox must not be empty
+    NodeMessage pop(size_t n){
+        Ring& ring = rings[n];
+        NodeMessage msg = arena[ring.start + ring.head];
+        ring.head = next(ring, ring.head);
+        --ring.count;
+        ++stats.popped;
+        return msg;
+    }
+
+private:
+    struct Ring{
+        uint64_t start;     // Offset of the ring's region in the arena
+        uint32_t capacity;
+        uint32_t head;      // Index of the oldest message within the region
+        uint32_t count;
+    };
+
+    static const size_t initial_unbounded_capacity = 4;
+    static const uint32_t max_ring_capacity = (uint32_t)1 << 31;
+
+    std::vector<NodeMessage> arena;
+    size_t arena_used = 0;
+    std::vector<Ring> rings;
+    size_t capacity = 0;
+    OverflowPolicy policy = DROP_NEWEST;
+
+    static uint32_t next(const Ring& ring, uint32_t i){
+        return i + 1 == ring.capacity ? 0 : i + 1;
+    }
+
+    // Moves a full ring to the end of the arena with twice the room, oldest message first
+    void grow(Ring& ring){
+        if(ring.capacity >= max_ring_capacity){
+            std::cout << "Error! A message queue outgrew " << max_ring_capacity << " messages" << std::endl;
+            exit(-1);
+        }
+        uint32_t new_capacity = ring.capacity * 2;
+        if(arena.size() < arena_used + new_capacity)
+            arena.resize(std::max(arena.size() * 2, arena_used + new_capacity));
+        uint32_t i = ring.head;
+        for(uint32_t k = 0; k < ring.count; ++k){
+            arena[arena_used + k] = arena[ring.start + i];
+            i = next(ring, i);
+        }
+        ring.start = arena_used;
+        ring.capacity = new_capacity;
+        ring.head = 0;
+        arena_used += new_capacity;
+    }
+};
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Per-evaluation metrics in a typed, columnar, append-only binary file (.gcm).
+//
+// Columns are declared once, each returning a handle; every row is then filled through
+// the handles and committed with end_row. Rows are buffered per column and written in
+// blocks. Each block holds every column's values encoded on their own, behind their
+// byte length, so a reader can skip the columns it doesn't need without decoding them.
+// A file cut short (e.g. a killed run) reads back up to its last complete block.
+//
+// Encodings (each block starts from a previous value of 0):
+//      int64   difference from the previous row, zigzagged, as a LEB128 varint, so ids,
+//              generations and counters that change slowly take a byte or two
+//      double  bits XORed with the previous row's: a byte with the number of zero bytes
+//              at the top (high nibble) and bottom (low nibble), then the bytes between;
+//              a repeated value is one byte, and nearby values share their top bytes
+//
+// Layout (little-endian, native on the machines we run on):
+//      header  magic "GCMETRC1", uint32 column count, then per column: uint8 type,
+//              uint16 name length, name
+//      block   uint32 row count, then per column: uint32 byte length, encoded values
+namespace Metrics{
+    enum Type : uint8_t{
+        INT64 = 0,
+        DOUBLE = 1
+    };
+
+    const char magic[8] = {'G', 'C', 'M', 'E', 'T', 'R', 'C', '1'};
+
+    inline void put_varint(std::vector<uint8_t>& out, uint64_t value){
+        while(value >= 0x80){
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    inline uint64_t get_varint(const uint8_t*& in, const uint8_t* end){
+        uint64_t value = 0;
+        for(int shift = 0; in < end && shift < 64; shift += 7){
+            uint8_t byte = *in++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if(!(byte & 0x80))
+                break;
+        }
+        return value;
+    }
+
+    // Values are held as raw 64-bit patterns, whatever the column type
+    inline void encode(Type type, const std::vector<uint64_t>& values, std::vector<uint8_t>& out){
+        out.clear();
+        uint64_t previous = 0;
+        for(uint64_t value : values){
+            if(type == INT64){
+                int64_t delta = (int64_t)(value - previous);
+                put_varint(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+            }
+            else{
+                uint64_t x = value ^ previous;
+                int top = 0, bottom = 0;
+                if(x == 0)
+                    top = 8;
+                else{
+                    while(!(x >> (56 - 8 * top) & 0xFF))
+                        ++top;
+                    while(!(x >> (8 * bottom) & 0xFF))
+                        ++bottom;
+                }
+                out.push_back((uint8_t)(top << 4 | bottom));
+                for(int b = bottom; b < 8 - top; ++b)
+                    out.push_back((uint8_t)(x >> (8 * b)));
+            }
+            previous = value;
+        }
+    }
+
+    inline void decode(Type type, const uint8_t* in, const uint8_t* end, size_t num_rows, std::vector<uint64_t>& values){
+        uint64_t previous = 0;
+        for(size_t row = 0; row < num_rows && in < end; ++row){
+            if(type == INT64){
+                uint64_t zigzag = get_varint(in, end);
+                previous += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+            }
+            else{
+                uint8_t counts = *in++;
+                int top = counts >> 4, bottom = counts & 0xF;
+                uint64_t x = 0;
+                for(int b = bottom; b < 8 - top && in < end; ++b)
+                    x |= (uint64_t)*in++ << (8 * b);
+                previous ^= x;
+            }
+            values.push_back(previous);
+        }
+    }
+}
+
+class MetricsLog{
+public:
+    struct Column{
+        size_t index;
+    };
+
+    std::string path;
+
+    ~MetricsLog(){
+        close();
+    }
+
+    bool is_open() const{
+        return file.is_open();
+    }
+
+    void open(const std::string& path_, size_t rows_per_block_ = 4096){
+        close();
+        path = path_;
+        rows_per_block = rows_per_block_ < 1 ? 1 : rows_per_block_;
+        file.open(path, std::ios::out | std::ios::binary);
+        if(!file.is_open()){
+            std::cout << "Error! Could not open " << path << " for writing" << std::endl;
+            exit(-1);
+        }
+        columns.clear();
+        header_written = false;
+        rows = 0;
+    }
+
+    // Columns must all be added before the first row
+    Column add_column(const std::string& name, Metrics::Type type){
+        if(header_written){
+            std::cout << "Metrics column " << name << " added to " << path << " after rows were written" << std::endl;
+            exit(-1);
+        }
+        columns.push_back({name, type, {}});
+        return Column{columns.size() - 1};
+    }
+
+    void set(Column column, int64_t value){
+        columns[column.index].values.push_back((uint64_t)value);
+    }
+
+    void set(Column column, double value){
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        columns[column.index].values.push_back(bits);
+    }
+
+    // Every column must have been set once since the last row
+    void end_row(){
+        if(++rows == rows_per_block)
+            write_block();
+    }
+
+    // Writes the buffered rows as a (short) block
+    void flush(){
+        if(!file.is_open())
+            return;
+        write_block();
+        file.flush();
+    }
+
+    void close(){
+        if(!file.is_open())
+            return;
+        flush();
+        file.close();
+    }
+
+private:
+    struct ColumnData{
+        std::string name;
+        Metrics::Type type;
+        std::vector<uint64_t> values;   // This block's rows
+    };
+
+    std::ofstream file;
+    std::vector<ColumnData> columns;
+    std::vector<uint8_t> encoded;
+    size_t rows_per_block = 4096, rows = 0;
+    bool header_written = false;
+
+    void write_header(){
+        file.write(Metrics::magic, sizeof(Metrics::magic));
+        uint32_t num_columns = columns.size();
+        file.write((const char*)&num_columns, sizeof(num_columns));
+        for(auto& column : columns){
+            uint8_t type = column.type;
+            uint16_t length = column.name.size();
+            file.write((const char*)&type, sizeof(type));
+            file.write((const char*)&length, sizeof(length));
+            file.write(column.name.data(), length);
+        }
+        header_written = true;
+    }
+
+    void write_block(){
+        if(!header_written)
+            write_header();
+        if(rows == 0)
+            return;
+        uint32_t num_rows = rows;
+        file.write((const char*)&num_rows, sizeof(num_rows));
+        for(auto& column : columns){
+            if(column.values.size() != rows){
+                std::cout << "Metrics column " << column.name << " has " << column.values.size()
+                          << " values for " << rows << " rows" << std::endl;
+                exit(-1);
+            }
+            Metrics::encode(column.type, column.values, encoded);
+            uint32_t length = encoded.size();
+            file.write((const char*)&length, sizeof(length));
+            file.write((const char*)encoded.data(), length);
+            column.values.clear();
+        }
+        rows = 0;
+    }
+};
+
+// Reads columns back from a .gcm file, decoding only the ones asked for
+class MetricsReader{
+public:
+    struct ColumnInfo{
+        std::string name;
+        Metrics::Type type;
+    };
+
+    std::vector<ColumnInfo> columns;
+
+    MetricsReader(const std::string& path_) : path(path_){
+        file.open(path, std::ios::in | std::ios::binary);
+        if(!file.is_open())
+            fail("could not open file");
+        char file_magic[sizeof(Metrics::magic)];
+        uint32_t num_columns = 0;
+        if(!file.read(file_magic, sizeof(file_magic)) || std::memcmp(file_magic, Metrics::magic, sizeof(file_magic)) != 0)
+            fail("not a metrics file");
+        file.read((char*)&num_columns, sizeof(num_columns));
+        for(uint32_t c = 0; c < num_columns && file; ++c){
+            uint8_t type = 0;
+            uint16_t length = 0;
+            file.read((char*)&type, sizeof(type));
+            file.read((char*)&length, sizeof(length));
+            std::string name(length, '\0');
+            file.read(&name[0], length);
+            columns.push_back({name, (Metrics::Type)type});
+        }
+        if(!file)
+            fail("truncated header");
+        data_start = file.tellg();
+        file.seekg(0, std::ios::end);
+        file_size = file.tellg();
+    }
+
+    // Index of the named column, or -1
+    int find(const std::string& name) const{
+        for(size_t c = 0; c < columns.size(); ++c){
+            if(columns[c].name == name)
+                return c;
+        }
+        return -1;
+    }
+
+    // Every row's raw 64-bit value in column c
+    std::vector<uint64_t> read_raw(size_t c){
+        std::vector<uint64_t> values;
+        std::vector<uint8_t> encoded;
+        file.clear();
+        file.seekg(data_start);
+        uint32_t num_rows = 0;
+        while(file.read((char*)&num_rows, sizeof(num_rows))){
+            size_t before = values.size();
+            bool complete = true;
+            for(size_t other = 0; other < columns.size(); ++other){
+                uint32_t length = 0;
+                if(!file.read((char*)&length, sizeof(length))){
+                    complete = false;
+                    break;
+                }
+                if(other != c){
+                    file.seekg(length, std::ios::cur);
+                    continue;
+                }
+                encoded.resize(length);
+                if(!file.read((char*)encoded.data(), length)){
+                    complete = false;
+                    break;
+                }
+                Metrics::decode(columns[c].type, encoded.data(), encoded.data() + length, num_rows, values);
+            }
+            // A block cut off mid-write (the writer was killed) is dropped
+            if(!complete || !file || file.tellg() > file_size){
+                values.resize(before);
+                break;
+            }
+        }
+        return values;
+    }
+
+    std::vector<int64_t> read_int(const std::string& name){
+        std::vector<uint64_t> raw = read_raw(require(name, Metrics::INT64));
+        return std::vector<int64_t>(raw.begin(), raw.end());
+    }
+
+    // Int columns are converted, so either type can be read as doubles
+    std::vector<double> read_double(const std::string& name){
+        int c = find(name);
+        if(c < 0)
+            fail("no column " + name);
+        std::vector<uint64_t> raw = read_raw(c);
+        std::vector<double> values(raw.size());
+        for(size_t row = 0; row < raw.size(); ++row){
+            if(columns[c].type == Metrics::INT64)
+                values[row] = (double)(int64_t)raw[row];
+            else
+                std::memcpy(&values[row], &raw[row], sizeof(double));
+        }
+        return values;
+    }
+
+private:
+    std::string path;
+    std::ifstream file;
+    std::streampos data_start, file_size;
+
+    void fail(const std::string& message) const{
+        std::cout << "Error reading metrics " << path << ": " << message << std::endl;
+        exit(-1);
+    }
+
+    size_t require(const std::string& name, Metrics::Type type) const{
+        int c = find(name);
+        if(c < 0)
+            fail("no column " + name);
+        if(columns[c].type != type)
+            fail("column " + name + " is not an int column");
+        return c;
+    }
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// The binary inputs each node's brain was last given, packed into one word per node, so
+// a delivery only writes the inputs that differ from what the brain already holds. An
+// idle node (no message, inputs already zero) costs a compare instead of a write per
+// input. Relies on brains keeping their inputs between updates, as MABE's brains do.
+class PackedInputs{
+public:
+    // width inputs per node, at most 64; nothing is known about the inputs until written
+    void reset(size_t num_nodes, size_t width_){
+        width = width_;
+        words.assign(num_nodes, 0);
+        known.assign(num_nodes, 0);
+    }
+
+    // Makes node's inputs [0, width) equal to the bits of word (bit i = input i), calling
+    // set_input(i, value) for each input that changes
+    template<class SetInput>
+    void write(size_t node, uint64_t word, const SetInput& set_input){
+        uint64_t changed = word ^ words[node];
+        if(!known[node]){
+            changed = width >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+            known[node] = 1;
+        }
+        words[node] = word;
+        while(changed != 0){
+            size_t i = __builtin_ctzll(changed);
+            set_input(i, (double)((word >> i) & 1));
+            changed &= changed - 1;
+        }
+    }
+
+private:
+    size_t width = 0;
+    std::vector<uint64_t> words;
+    std::vector<uint8_t> known;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+// Per-phase instrumentation of the lifetime loop. Compiled in only when
+// GRAPH_COLOR_ENABLE_PERF is defined (uncomment the line below, or add
+// -DGRAPH_COLOR_ENABLE_PERF to the compiler flags); otherwise GRAPH_COLOR_PERF(...)
+// expands to nothing and the loop is untouched.
+//
+// With it on, every generation appends one row to perf.csv in graphOutputDir: the time
+// spent in each phase of the loop, summed over every evaluation, and the message traffic.
+
+// #define GRAPH_COLOR_ENABLE_PERF
+
+#ifdef GRAPH_COLOR_ENABLE_PERF
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+// Local includes
+#include "./MessageQueues.h"
+
+#define GRAPH_COLOR_PERF(...) __VA_ARGS__
+
+class PerfCounters{
+public:
+    enum Phase{
+        INPUT,      // Popping messages and setting inputs
+        UPDATE,     // Brain updates
+        SHUFFLE,    // Shuffling the node order
+        OUTPUT,     // Decoding outputs: recoloring and routing messages
+        CHECK,      // Checking whether the coloring is valid
+        NUM_PHASES
+    };
+
+    uint64_t phase_time[NUM_PHASES] = {};   // In timestamp counter cycles (nanoseconds where there is none)
+    size_t evaluations = 0;
+    size_t ticks = 0;
+    size_t sent = 0;            // Messages pushed to an inbox, including dropped ones
+    size_t delivered = 0;
+    size_t dropped = 0;
+    size_t queued = 0;          // Messages waiting in inboxes, summed over the end of every tick
+    size_t high_water = 0;      // Longest any inbox has been
+
+    static const char* phase_name(Phase phase){
+        static const char* names[NUM_PHASES] = {"input", "update", "shuffle", "output", "check"};
+        return names[phase];
+    }
+
+    static uint64_t now(){
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Starts timing a tick's first phase
+    void begin(){
+        last = now();
+    }
+
+    // Charges the time since the previous lap (or begin) to phase
+    void lap(Phase phase){
+        uint64_t t = now();
+        phase_time[phase] += t - last;
+        last = t;
+    }
+
+    // At the end of every tick
+    void end_tick(const MessageQueues::Stats& queue_stats){
+        ++ticks;
+        queued += queue_stats.pushed - queue_stats.popped - queue_stats.dropped;
+    }
+
+    // At the end of every evaluation
+    void end_evaluation(const MessageQueues::Stats& queue_stats){
+        ++evaluations;
+        sent += queue_stats.pushed;
+        delivered += queue_stats.popped;
+        dropped += queue_stats.dropped;
+        high_water = std::max(high_water, queue_stats.high_water);
+    }
+
+    void merge(const PerfCounters& other){
+        for(int p = 0; p < NUM_PHASES; ++p)
+            phase_time[p] += other.phase_time[p];
+        evaluations += other.evaluations;
+        ticks += other.ticks;
+        sent += other.sent;
+        delivered += other.delivered;
+        dropped += other.dropped;
+        queued += other.queued;
+        high_water = std::max(high_water, other.high_water);
+    }
+
+    static void write_header(std::ostream& out){
+        out << "generation,evaluations,ticks";
+        for(int p = 0; p < NUM_PHASES; ++p)
+            out << "," << phase_name((Phase)p) << "_cycles";
+        for(int p = 0; p < NUM_PHASES; ++p)
+            out << "," << phase_name((Phase)p) << "_cycles_per_tick";
+        out << ",sent,delivered,dropped,mean_queued,queue_high_water" << std::endl;
+    }
+
+    void write_row(std::ostream& out, size_t generation) const{
+        double per_tick = ticks > 0 ? 1.0 / ticks : 0;
+        out << generation << "," << evaluations << "," << ticks;
+        for(int p = 0; p < NUM_PHASES; ++p)
+            out << "," << phase_time[p];
+        for(int p = 0; p < NUM_PHASES; ++p)
+            out << "," << phase_time[p] * per_tick;
+        out << "," << sent << "," << delivered << "," << dropped << "," << queued * per_tick
+            << "," << high_water << std::endl;
+    }
+
+private:
+    uint64_t last = 0;
+};
+
+#else
+
+#define GRAPH_COLOR_PERF(...)
+
+#endif
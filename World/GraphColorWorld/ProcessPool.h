@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Runs a batch of independent tasks across forked worker processes, for brains that are
+// not safe to share a process between threads. Workers are forked at the start of every
+// run, so each one sees a copy-on-write snapshot of the parent: the population's brains
+// and the current graph topology are shared pages, and nothing has to be serialized.
+// Tasks are handed out through a lock-free counter in a shared-memory segment, and each
+// task writes its result (which must be trivially copyable) into the same segment.
+// The calling process takes part as worker 0, so a pool of size 1 never forks.
+//
+// Anything else a forked worker changes in its own memory (counters, statistics) is lost
+// when it exits, so each one can also fill in a Report that is handed back to the parent.
+// A forked child only gets the thread that forked it, and a lock another thread held at
+// the fork stays locked in the child, so the caller must stop its other threads around
+// the fork (see before_fork) or not use the pool while they run.
+template<class Result, class Report = char>
+class ProcessPool{
+    static_assert(std::is_trivially_copyable<Result>::value, "ProcessPool results are copied through shared memory");
+    static_assert(std::is_trivially_copyable<Report>::value, "ProcessPool reports are copied through shared memory");
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "ProcessPool needs lock-free 64-bit atomics to share a counter between processes");
+
+public:
+    ProcessPool(size_t num_workers) : num_workers(num_workers < 1 ? 1 : num_workers){}
+
+    ~ProcessPool(){
+        if(segment != nullptr)
+            munmap(segment, segment_bytes);
+    }
+
+    size_t size() const{
+        return num_workers;
+    }
+
+    // Called in the parent right before the workers are forked and right after (only when
+    // a run forks), e.g. to stop a background thread and restart it
+    std::function<void()> before_fork, after_fork;
+
+    // Runs task(id, result) for every id in [0, num_tasks) and blocks until all are done;
+    // results[id] is whatever task id wrote to its result
+    template<class Task>
+    void run(size_t num_tasks, std::vector<Result>& results, const Task& task){
+        std::vector<Report> reports;
+        run(num_tasks, results, task, reports, [](Report&){});
+    }
+
+    // Same, and every forked worker calls report(its_report) after its last task; reports
+    // gets one per forked worker (the calling process's own work is not in it)
+    template<class Task, class Reporter>
+    void run(size_t num_tasks, std::vector<Result>& results, const Task& task,
+             std::vector<Report>& reports, const Reporter& report){
+        results.resize(num_tasks);
+        reports.clear();
+        if(num_tasks == 0)
+            return;
+        reserve(num_tasks);
+        Header* header = reinterpret_cast<Header*>(segment);
+        Result* shared_results = reinterpret_cast<Result*>(segment + results_offset);
+        Report* shared_reports = reinterpret_cast<Report*>(segment + reports_offset());
+        header->next_task.store(0);
+
+        // Buffered output would otherwise be written once per process
+        std::cout.flush();
+        std::fflush(stdout);
+        size_t num_children = std::min(num_workers, num_tasks) - 1;
+        if(num_children > 0 && before_fork)
+            before_fork();
+        std::vector<pid_t> children;
+        for(size_t w = 1; w <= num_children; ++w){
+            pid_t pid = fork();
+            if(pid < 0){
+                std::cout << "ProcessPool could not fork worker " << w << std::endl;
+                exit(-1);
+            }
+            if(pid == 0){
+                work(header, shared_results, num_tasks, task);
+                report(shared_reports[w - 1]);
+                std::cout.flush();
+                std::fflush(stdout);
+                // Skip the parent's destructors and atexit handlers, they belong to the parent
+                _exit(0);
+            }
+            children.push_back(pid);
+        }
+        if(num_children > 0 && after_fork)
+            after_fork();
+        work(header, shared_results, num_tasks, task);
+
+        bool failed = false;
+        for(pid_t pid : children){
+            int status = 0;
+            while(waitpid(pid, &status, 0) < 0){
+                if(errno != EINTR){
+                    status = -1;
+                    break;
+                }
+            }
+            if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                failed = true;
+        }
+        if(failed){
+            std::cout << "A ProcessPool worker exited abnormally; its evaluations are lost" << std::endl;
+            exit(-1);
+        }
+        for(size_t id = 0; id < num_tasks; ++id)
+            results[id] = shared_results[id];
+        reports.assign(shared_reports, shared_reports + num_children);
+    }
+
+private:
+    struct Header{
+        std::atomic<uint64_t> next_task;
+    };
+
+    size_t num_workers;
+    char* segment = nullptr;
+    size_t segment_bytes = 0;
+    size_t capacity = 0;
+    static constexpr size_t results_offset = (sizeof(Header) + alignof(Result) - 1) / alignof(Result) * alignof(Result);
+
+    // Reports follow the results
+    size_t reports_offset() const{
+        size_t end = results_offset + capacity * sizeof(Result);
+        return (end + alignof(Report) - 1) / alignof(Report) * alignof(Report);
+    }
+
+    // Maps a shared segment big enough for num_tasks results, if the current one isn't
+    void reserve(size_t num_tasks){
+        if(num_tasks <= capacity)
+            return;
+        if(segment != nullptr)
+            munmap(segment, segment_bytes);
+        capacity = num_tasks;
+        segment_bytes = reports_offset() + num_workers * sizeof(Report);
+        void* memory = mmap(nullptr, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED){
+            std::cout << "ProcessPool could not map " << segment_bytes << " bytes of shared memory" << std::endl;
+            exit(-1);
+        }
+        segment = static_cast<char*>(memory);
+        new (segment) Header();
+    }
+
+    template<class Task>
+    static void work(Header* header, Result* shared_results, size_t num_tasks, const Task& task){
+        for(size_t id = header->next_task.fetch_add(1); id < num_tasks; id = header->next_task.fetch_add(1)){
+            Result result;
+            task(id, result);
+            shared_results[id] = result;
+        }
+    }
+};
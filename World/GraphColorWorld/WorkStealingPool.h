@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small fixed-size thread pool for running a batch of independent tasks.
+// Tasks are handed out up front as contiguous blocks, one block per worker. A
+// worker pops from the back of its own deque and, once that is empty, steals
+// from the front of the other workers' deques, so uneven task costs (e.g.,
+// evaluations that terminate early) still balance out.
+// The calling thread takes part as worker 0, so a pool of size 1 spawns no threads.
+class WorkStealingPool{
+public:
+    using Task = std::function<void(size_t task_id, size_t worker_id)>;
+
+    WorkStealingPool(size_t num_workers){
+        if(num_workers < 1)
+            num_workers = 1;
+        queues = std::vector<TaskQueue>(num_workers);
+        for(size_t w = 1; w < num_workers; ++w){
+            threads.push_back(std::thread(&WorkStealingPool::worker_loop, this, w));
+        }
+    }
+
+    ~WorkStealingPool(){
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            shutting_down = true;
+        }
+        start_cv.notify_all();
+        for(auto& thread : threads)
+            thread.join();
+    }
+
+    size_t size() const{
+        return queues.size();
+    }
+
+    // Runs task(id, worker) for every id in [0, num_tasks) and blocks until all are done
+    void run(size_t num_tasks, const Task& task){
+        if(num_tasks == 0)
+            return;
+        current_task = &task;
+        remaining = num_tasks;
+        size_t block = (num_tasks + queues.size() - 1) / queues.size();
+        for(size_t w = 0; w < queues.size(); ++w){
+            std::lock_guard<std::mutex> lock(queues[w].mutex);
+            for(size_t id = w * block; id < num_tasks && id < (w + 1) * block; ++id)
+                queues[w].tasks.push_back(id);
+        }
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            ++epoch;
+        }
+        start_cv.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(pool_mutex);
+        done_cv.wait(lock, [this]{ return remaining == 0; });
+        current_task = nullptr;
+    }
+
+private:
+    struct TaskQueue{
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<TaskQueue> queues;
+    std::vector<std::thread> threads;
+    std::mutex pool_mutex;
+    std::condition_variable start_cv, done_cv;
+    size_t epoch = 0;
+    bool shutting_down = false;
+    std::atomic<size_t> remaining{0};
+    const Task* current_task = nullptr;
+
+    bool pop_own(size_t worker_id, size_t& task_id){
+        std::lock_guard<std::mutex> lock(queues[worker_id].mutex);
+        if(queues[worker_id].tasks.empty())
+            return false;
+        task_id = queues[worker_id].tasks.back();
+        queues[worker_id].tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t worker_id, size_t& task_id){
+        for(size_t offset = 1; offset < queues.size(); ++offset){
+            TaskQueue& victim = queues[(worker_id + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if(!victim.tasks.empty()){
+                task_id = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Drains the worker's own queue, then steals until every queue is empty
+    void work(size_t worker_id){
+        size_t task_id;
+        while(pop_own(worker_id, task_id) || steal(worker_id, task_id)){
+            (*current_task)(task_id, worker_id);
+            if(--remaining == 0){
+                std::lock_guard<std::mutex> lock(pool_mutex);
+                done_cv.notify_all();
+            }
+        }
+    }
+
+    void worker_loop(size_t worker_id){
+        size_t seen_epoch = 0;
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(pool_mutex);
+                start_cv.wait(lock, [&]{ return shutting_down || epoch != seen_epoch; });
+                if(shutting_down)
+                    return;
+                seen_epoch = epoch;
+            }
+            work(worker_id);
+        }
+    }
+};